@@ -0,0 +1,117 @@
+// arena.h - monotonic allocator for cash flow storage
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <vector>
+
+namespace fixed_income {
+
+	// Bump allocator handing out memory from a chain of blocks.
+	// Deallocation is a no-op and reset() frees everything in O(1) while keeping
+	// the blocks for the next cycle. Not thread safe: use one arena per thread.
+	class arena {
+		struct block {
+			std::unique_ptr<char[]> p;
+			size_t n;
+		};
+		std::vector<block> block_;
+		size_t size_; // default block size
+		size_t i_;    // current block
+		size_t used_; // bytes used in current block
+
+		static size_t align_up(size_t n, size_t a)
+		{
+			return (n + a - 1) & ~(a - 1);
+		}
+	public:
+		explicit arena(size_t size = 1 << 16)
+			: size_(size), i_(0), used_(0)
+		{ }
+		arena(const arena&) = delete;
+		arena& operator=(const arena&) = delete;
+
+		void* allocate(size_t n, size_t a = alignof(std::max_align_t))
+		{
+			while (i_ < block_.size()) {
+				uintptr_t b = reinterpret_cast<uintptr_t>(block_[i_].p.get());
+				size_t off = align_up(b + used_, a) - b;
+				if (off + n <= block_[i_].n) {
+					used_ = off + n;
+
+					return block_[i_].p.get() + off;
+				}
+				++i_;
+				used_ = 0;
+			}
+
+			block bi;
+			bi.n = n + a > size_ ? n + a : size_;
+			bi.p.reset(new char[bi.n]);
+			block_.push_back(std::move(bi));
+			i_ = block_.size() - 1;
+			used_ = 0;
+
+			return allocate(n, a);
+		}
+		void deallocate(void*, size_t)
+		{ }
+
+		// free everything allocated so far
+		void reset(void)
+		{
+			i_ = 0;
+			used_ = 0;
+		}
+		// bytes held by the arena
+		size_t capacity(void) const
+		{
+			size_t n = 0;
+
+			for (const auto& b : block_)
+				n += b.n;
+
+			return n;
+		}
+	};
+
+	// standard allocator drawing from an arena
+	template<class T>
+	class arena_allocator {
+		template<class U> friend class arena_allocator;
+		arena* a_;
+	public:
+		typedef T value_type;
+
+		arena_allocator(arena& a)
+			: a_(&a)
+		{ }
+		template<class U>
+		arena_allocator(const arena_allocator<U>& a)
+			: a_(a.a_)
+		{ }
+
+		T* allocate(size_t n)
+		{
+			return static_cast<T*>(a_->allocate(n*sizeof(T), alignof(T)));
+		}
+		void deallocate(T* p, size_t n)
+		{
+			a_->deallocate(p, n*sizeof(T));
+		}
+
+		template<class U>
+		bool operator==(const arena_allocator<U>& a) const
+		{
+			return a_ == a.a_;
+		}
+		template<class U>
+		bool operator!=(const arena_allocator<U>& a) const
+		{
+			return a_ != a.a_;
+		}
+	};
+
+} // namespace fixed_income
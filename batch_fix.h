@@ -0,0 +1,118 @@
+// batch_fix.h - fix a set of instruments from indicative data and quotes in one call
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <memory>
+#include <vector>
+#include "datetime.h"
+#include "ensure.h"
+#include "fixed_income.h"
+#include "parallel.h"
+#include "schedule_cache.h"
+
+using datetime::date;
+using datetime::holiday_calendar;
+
+namespace fixed_income {
+
+	enum instrument_type {
+		INSTRUMENT_CASH_DEPOSIT,          // settles settle_ business days after valuation
+		INSTRUMENT_FORWARD_RATE_AGREEMENT, // starts on eff_
+		INSTRUMENT_INTEREST_RATE_SWAP,     // starts on eff_, fixed leg paid at freq_
+	};
+
+	// Indicative data and quote with the same meaning as the arguments of the
+	// instrument constructors and fix().
+	template<class T = double>
+	struct indicative {
+		instrument_type type_;
+		int settle_;   // cash deposit
+		date eff_;     // forward rate agreement and swap
+		int count_; datetime::time_unit unit_;
+		datetime::payment_frequency freq_; // swap
+		datetime::day_count_basis dcb_;
+		datetime::roll_convention roll_;
+		holiday_calendar cal_;
+		T quote_;      // rate, forward or coupon
+	};
+
+	// Schedules of a set of instruments resolved once for a valuation date.
+	// fix() then writes the cash flows for a quote snapshot in structure of arrays form:
+	// instrument i has times t[offset(i)] to t[offset(i + 1) - 1] and amounts in c.
+	// Instruments with identical conventions share one schedule from the cache.
+	template<class T = double>
+	class batch_fixing {
+		std::vector<std::shared_ptr<const schedule<T>>> s_;
+		std::vector<T> t0_;      // start time from valuation
+		std::vector<size_t> off_;
+	public:
+		batch_fixing(const date& val, size_t n, const indicative<T>* r, schedule_cache<T>& cache = schedules<T>())
+			: s_(n), t0_(n), off_(n + 1)
+		{
+			off_[0] = 0;
+			for (size_t i = 0; i < n; ++i) {
+				const indicative<T>& ri = r[i];
+
+				if (ri.type_ == INSTRUMENT_CASH_DEPOSIT) {
+					s_[i] = cache.get(val, ri.settle_, ri.count_, ri.unit_, datetime::FREQ_NONE, ri.roll_, ri.cal_, ri.dcb_);
+					t0_[i] = 0; // schedule is measured from val
+				}
+				else {
+					datetime::payment_frequency freq = ri.type_ == INSTRUMENT_INTEREST_RATE_SWAP ? ri.freq_ : datetime::FREQ_NONE;
+					s_[i] = cache.get(ri.eff_, 0, ri.count_, ri.unit_, freq, ri.roll_, ri.cal_, ri.dcb_);
+					t0_[i] = static_cast<T>(ri.eff_.diffyears(val));
+					ensure (t0_[i] >= 0);
+				}
+
+				off_[i + 1] = off_[i] + s_[i]->size();
+			}
+		}
+
+		// number of instruments
+		size_t size(void) const
+		{
+			return s_.size();
+		}
+		// number of cash flows of all instruments
+		size_t flows(void) const
+		{
+			return off_.back();
+		}
+		size_t offset(size_t i) const
+		{
+			return off_[i];
+		}
+
+		// Cash flows for the records used to construct this with current quotes.
+		// t and c need room for flows(). No allocation.
+		void fix(const indicative<T>* r, T* t, T* c, size_t threads = std::thread::hardware_concurrency()) const
+		{
+			parallel::for_range(size(), [&](size_t b, size_t e) {
+				for (size_t i = b; i < e; ++i) {
+					const schedule<T>& s = *s_[i];
+					T q = r[i].quote_;
+					T* ti = t + off_[i];
+					T* ci = c + off_[i];
+
+					ti[0] = t0_[i] + s.t[0];
+					ci[0] = -1;
+					for (size_t j = 1; j < s.size(); ++j) {
+						ti[j] = t0_[i] + s.t[j];
+						ci[j] = static_cast<T>(q*s.dcf[j]);
+					}
+					// principal
+					if (r[i].type_ == INSTRUMENT_INTEREST_RATE_SWAP)
+						ci[s.size() - 1] += 1;
+					else
+						ci[1] = 1 + q*s.dcf[1];
+				}
+			}, threads);
+		}
+
+		// view of instrument i in buffers written by fix()
+		instrument<T> operator()(size_t i, const T* t, const T* c) const
+		{
+			return instrument<T>(off_[i + 1] - off_[i], t + off_[i], c + off_[i]);
+		}
+	};
+
+} // namespace fixed_income
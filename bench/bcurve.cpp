@@ -0,0 +1,123 @@
+// bcurve.cpp - compare build and discount cost of forward curve types
+// g++ -std=c++11 -O2 -I.. bcurve.cpp
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "../ensure.h"
+#include "../integral_grid.h"
+#include "../pwflat_yield_curve.h"
+#include "../pwlinear.h"
+#include "../monotone_convex.h"
+
+template<class F>
+inline double seconds(const F& f)
+{
+	auto t0 = std::chrono::high_resolution_clock::now();
+	f();
+	auto t1 = std::chrono::high_resolution_clock::now();
+
+	return std::chrono::duration<double>(t1 - t0).count();
+}
+
+template<class C>
+inline double discount_sum(const C& c, const std::vector<double>& u)
+{
+	double s = 0;
+
+	for (double ui : u)
+		s += c.discount(ui);
+
+	return s;
+}
+
+int
+main(void)
+{
+	const size_t n = 40;  // knots
+	const size_t m = 1000000; // discounts
+	const size_t builds = 1000;
+
+	// par swaps with annual coupons
+	std::vector<double> t(n + 1), c(n + 1);
+	for (size_t i = 0; i <= n; ++i)
+		t[i] = static_cast<double>(i);
+
+	std::vector<double> u(m);
+	for (size_t j = 0; j < m; ++j)
+		u[j] = n*(j + 0.5)/m;
+
+	pwflat::yield_curve<> yc;
+	pwlinear::forward_curve<> lc;
+	double s;
+
+	auto swap = [&](size_t k) {
+		double r = 0.02 + 0.0005*k;
+		c[0] = -1;
+		for (size_t i = 1; i <= k; ++i)
+			c[i] = r + (i == k);
+	};
+
+	double pf_build = seconds([&]() {
+		for (size_t b = 0; b < builds; ++b) {
+			yc.reset();
+			for (size_t k = 1; k <= n; ++k) {
+				swap(k);
+				yc.add(k + 1, &t[0], &c[0]);
+			}
+		}
+	});
+	double pl_build = seconds([&]() {
+		for (size_t b = 0; b < builds; ++b) {
+			lc = pwlinear::forward_curve<>();
+			for (size_t k = 1; k <= n; ++k) {
+				swap(k);
+				lc.add(k + 1, &t[0], &c[0]);
+			}
+		}
+	});
+	monotone_convex::forward_curve<> mc;
+	double mc_build = seconds([&]() {
+		for (size_t b = 0; b < builds; ++b)
+			mc = monotone_convex::forward_curve<>(yc.forward_curve());
+	}) + pf_build;
+
+	auto pf = yc.forward_curve();
+	struct { const pwflat::forward_curve<>& f; double discount(double x) const { return pwflat::discount(x, f); } } pd = {pf};
+
+	pwflat::knot_index<> ki(pf.n, pf.t, pf.f);
+	auto pfi = pf;
+	pfi.set_index(&ki);
+	struct { const pwflat::forward_curve<>& f; double discount(double x) const { return pwflat::discount(x, f); } } pdi = {pfi};
+
+	double pf_disc = seconds([&]() { s = discount_sum(pd, u); });
+	double pfi_disc = seconds([&]() { s += discount_sum(pdi, u); });
+	double pl_disc = seconds([&]() { s += discount_sum(lc, u); });
+	double mc_disc = seconds([&]() { s += discount_sum(mc, u); });
+
+	// batch integrals, one curve and many times
+	std::vector<double> I(m);
+	double grid_int[pwflat::SIMD_AVX512 + 1] = {0};
+	for (int level = pwflat::SIMD_SCALAR; level <= pwflat::simd_support(); ++level) {
+		pwflat::integral_grid<> g(pf.n, pf.t, pf.f, pf._f, static_cast<pwflat::simd_level>(level));
+		grid_int[level] = seconds([&]() { g.integral(m, &u[0], &I[0]); s += I[m/2]; });
+	}
+	double pf_int = seconds([&]() { for (double ui : u) s += pf.integral(ui); });
+
+	printf("%zu knots, %zu builds, %zu discounts\n", n, builds, m);
+	printf("%-16s %12s %12s\n", "curve", "build (us)", "discount (ns)");
+	printf("%-16s %12.2f %12.2f\n", "pwflat", 1e6*pf_build/builds, 1e9*pf_disc/m);
+	printf("%-16s %12s %12.2f\n", "pwflat+index", "", 1e9*pfi_disc/m);
+	printf("%-16s %12.2f %12.2f\n", "pwlinear", 1e6*pl_build/builds, 1e9*pl_disc/m);
+	printf("%-16s %12.2f %12.2f\n", "monotone_convex", 1e6*mc_build/builds, 1e9*mc_disc/m);
+
+	printf("%-16s %12s %12s\n", "integral", "", "(ns)");
+	printf("%-16s %12s %12.2f\n", "pwflat", "", 1e9*pf_int/m);
+	for (int level = pwflat::SIMD_SCALAR; level <= pwflat::simd_support(); ++level)
+		printf("%-16s %12s %12.2f\n", (std::string("grid ") + pwflat::simd_name(static_cast<pwflat::simd_level>(level))).c_str(), "", 1e9*grid_int[level]/m);
+	printf("default grid level: %s, fastest measured: %s\n", pwflat::simd_name(pwflat::integral_grid<>(pf.n, pf.t, pf.f, pf._f).level()),
+		pwflat::simd_name(pwflat::integral_grid_fastest<double>()));
+
+	return s > 0 ? 0 : 1;
+}
@@ -1,6 +1,10 @@
 // bootstrap.h - bootstrap a piecewise-flat forward curve
 // Copyright (c) 2013 KALX, LLC. All rights reserved.
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <utility>
 #include "ensure.h"
 #include "fixed_income.h"
 #include "newton.h"
@@ -35,12 +39,14 @@ namespace pwflat {
 		T D0 = discount(t0, n, t, f);
 		T d = -c1/c0; // works if c0 != -1
 
-		if (u0 < t0) { // overlap or cash deposit
-			T Dm = discount(u1, n, t, f);
-			_f = static_cast<T>(log(d*D0/Dm)/(u1 - u0));
+		ensure (u1 > t0);
+
+		if (u0 < t0) { // overlap or cash deposit: D(u0)/D(u1) = d, D(u1) = D0 exp(-_f (u1 - t0))
+			T Du0 = discount(u0, n, t, f);
+			_f = static_cast<T>(log(d*D0/Du0)/(u1 - t0));
 		}
-		else { // underlap
-			_f = static_cast<T>(log(d)/(u1 - t0));
+		else { // adjacent or underlap: flat from t0 to u1
+			_f = static_cast<T>(log(d)/(u1 - u0));
 		}
 
 		return _f;
@@ -51,8 +57,139 @@ namespace pwflat {
 		return bootstrap2(u0, c0, u1, c1, f.n, f.t, f.f);
 	}
 
+	// Solve sum c[j] exp(-(a[j] + b[j] x)) = p for x where int_0^u[j] f = a[j] + b[j] x
+	// is affine in the parameter x of the new segment. Curves other than piecewise flat
+	// bootstrap by providing a and b.
+	template<class T>
+	inline T bootstrap_affine(size_t m, const T* a, const T* b, const T* c, T x, T p = 0)
+	{
+		auto F = [m,a,b,c,p](T x_) {
+			T pv(-p);
+
+			for (size_t j = 0; j < m; ++j)
+				pv += c[j]*exp(-a[j] - b[j]*x_);
+
+			return pv;
+		};
+		auto dF = [m,a,b,c](T x_) {
+			T dur(0);
+
+			for (size_t j = 0; j < m; ++j)
+				dur -= b[j]*c[j]*exp(-a[j] - b[j]*x_);
+
+			return dur;
+		};
+
+		return root1d::newton(x, F, dF);
+	}
+
+	// Solve sum c[j] exp(-(I0 + x tau[j])) = K for x given the times tau[j] - t0 past the last knot t0,
+	// I0 = int_0^t0 f and K = p - p0. Each Newton step is m exp calls.
+	template<class T>
+	inline T bootstrap_tail(size_t m, const T* tau, const T* c, T K, T x, T I0 = 0, size_t* steps = 0, T t0 = 0)
+	{
+		auto FdF = [m,tau,c,K,I0,t0](T x_) {
+			T pv(-K), dur(0);
+
+			for (size_t j = 0; j < m; ++j) {
+				T tau_j = tau[j] - t0;
+				T w = c[j]*exp(-(I0 + x_*tau_j));
+				pv += w;
+				dur -= tau_j*w;
+			}
+
+			return std::make_pair(pv, dur);
+		};
+
+		return root1d::newton_fdf(x, FdF, static_cast<size_t>(-1), steps);
+	}
+
+	// Returns k > 0 and sets dt if tau[j] - t0 = (k + j) dt for all j, e.g. a swap with the same
+	// frequency as the previous knot, otherwise 0.
+	template<class T>
+	inline size_t equal_spacing(size_t m, const T* tau, T& dt, T t0 = 0)
+	{
+		if (m == 0 || !(tau[0] - t0 > 0))
+			return 0;
+		if (m == 1) {
+			dt = tau[0] - t0;
+
+			return 1;
+		}
+
+		T d = (tau[1] - t0) - (tau[0] - t0);
+		if (!(d > 0))
+			return 0;
+		T k = floor((tau[0] - t0)/d + static_cast<T>(0.5));
+		if (k < 1)
+			return 0;
+
+		T taum = tau[m-1] - t0;
+		dt = taum/(k + m - 1);
+		T tol = 8*std::numeric_limits<T>::epsilon()*taum;
+		for (size_t j = 0; j < m; ++j) {
+			if (!(fabs((tau[j] - t0) - (k + j)*dt) <= tol))
+				return 0;
+		}
+
+		return static_cast<size_t>(k);
+	}
+
+	// Solve z^k sum c[j] z^j = K for z > 0 where z = exp(-x dt) on equally spaced flows.
+	// Closed form for one flow or a quadratic, otherwise Newton with Horner evaluation and no exp calls
+	// safeguarded by a bracket in (0, 1], widened past 1 for negative rates.
+	// Returns NaN if no positive root was bracketed.
+	template<class T>
+	inline T bootstrap_polynomial(size_t m, size_t k, const T* c, T K, T z, size_t* steps = 0)
+	{
+		ensure (m && k);
+
+		if (m == 1) {
+			z = K/c[0];
+
+			return z > 0 ? pow(z, 1/static_cast<T>(k)) : std::numeric_limits<T>::quiet_NaN();
+		}
+		if (m == 2 && k == 1 && c[1] != 0) { // c[1] z^2 + c[0] z - K = 0
+			T d = c[0]*c[0] + 4*c[1]*K;
+			if (d >= 0) {
+				T q = c[0] + (c[0] >= 0 ? sqrt(d) : -sqrt(d)); // no cancellation
+				T z0 = -q/(2*c[1]), z1 = q != 0 ? 2*K/q : z0;
+				z = z1 > 0 ? z1 : z0;
+
+				return z > 0 ? z : std::numeric_limits<T>::quiet_NaN();
+			}
+		}
+
+		auto FdF = [m,k,c,K](T z_) {
+			T q(0), dq(0);
+			for (size_t j = m; j--; ) {
+				dq = dq*z_ + q;
+				q = q*z_ + c[j];
+			}
+			T zk(1);
+			for (size_t i = 1; i < k; ++i)
+				zk *= z_;
+
+			return std::make_pair(zk*z_*q - K, zk*(k*q + z_*dq));
+		};
+
+		// f(0) = -K, widen (0, hi] until f changes sign
+		T lo(0), hi(1);
+		T f0 = -K, fhi = FdF(hi).first;
+		for (int i = 0; i < 16 && f0 != 0 && (f0 < 0) == (fhi < 0); ++i) {
+			lo = hi;
+			hi *= 2;
+			fhi = FdF(hi).first;
+		}
+
+		z = root1d::newton_bracket(z, FdF, lo, hi, 200, steps);
+
+		return z > 0 ? z : std::numeric_limits<T>::quiet_NaN();
+	}
+
+	// Newton steps taken are added to *steps if not null, none for the closed forms
 	template<class T>
-	inline T bootstrap(size_t m, const T* u, const T* c, size_t n, const T* t, const T* f, T _f = 0, T p = 0)
+	inline T bootstrap(size_t m, const T* u, const T* c, size_t n, const T* t, const T* f, T _f = 0, T p = 0, size_t* steps = 0)
 	{
 		ensure (m && (n == 0 || u[m-1] > t[n-1]));
 
@@ -68,26 +205,29 @@ namespace pwflat {
 		
 		T t0 = n ? t[n-1] : 0;
 		const T* um = std::upper_bound(u, u + m, t0);
-		ensure (um != u + m); // already checked above
+		ensure_debug (um != u + m); // already checked above
 		T p0 = present_value<T>(um - u, u, c, n, t, f);
 
 		m -= um - u;
 		c += um - u;
 		u += um - u;
 
-		auto F = [p,p0,m,u,c,n,t,f](T _f) 
-		{ 
-			return -p + p0 + present_value<T>(fixed_income::instrument<T>(m, u, c), forward_curve<T>(n, t, f, _f)); 
-		};
-		auto dF = [t0,m,u,c,n,t,f](T _f) 
-		{ 
-			return duration<T>(fixed_income::instrument<T>(m, u, c), forward_curve<T>(n, t, f, _f), t0);
-		};
+		// only _f changes: D(u[j]) = D(t0) exp(-_f (u[j] - t0)), offsets are taken from u and t0
+		T I0 = integral(t0, n, t, f);
 
 		if (_f == 0)
 			_f = n ? f[n-1] : static_cast<T>(0.01);
 
-		return root1d::newton(_f, F, dF);
+		// equally spaced flows are a polynomial in z = exp(-_f dt)
+		T dt;
+		size_t k = equal_spacing<T>(m, u, dt, t0);
+		if (k) {
+			T z = bootstrap_polynomial<T>(m, k, c, (p - p0)*exp(I0), exp(-_f*dt), steps);
+			if (z > 0)
+				return -log(z)/dt;
+		}
+
+		return bootstrap_tail<T>(m, u, c, p - p0, _f, I0, steps, t0);
 	}
 	template<class T>
 	inline T bootstrap(const fixed_income::instrument<T>& i, const forward_curve<T>& f, T _f = 0, T p = 0)
@@ -95,4 +235,55 @@ namespace pwflat {
 		return bootstrap(i.n, i.t, i.c, f.n, f.t, f.f, _f, p);
 	}
 
+	// result of bootstrap_try
+	template<class T = double>
+	struct bootstrap_status {
+		bool converged;       // forward found and the instrument reprices
+		size_t iterations;    // Newton steps, 0 for cash deposits and forward rate agreements
+		T residual;           // present value minus price on the extended curve
+		size_t index;         // failed instrument, -1 if none
+		ensure_failure check; // failed precondition, file is null if none
+	};
+
+	// Same as bootstrap but sets the forward in _f and reports failure in the status
+	// instead of throwing or returning NaN. _f is unchanged if it did not converge.
+	template<class T>
+	inline bootstrap_status<T> bootstrap_try(size_t m, const T* u, const T* c, size_t n, const T* t, const T* f, T& _f, T p = 0)
+	{
+		bootstrap_status<T> s = {false, 0, std::numeric_limits<T>::quiet_NaN(), 0, {0, 0, 0}};
+
+		// input checks do not depend on ENSURE_LEVEL
+		if (!ensure_status(m != 0, &s.check)
+		|| !ensure_status(n == 0 || u[m-1] > t[n-1], &s.check)
+		|| !ensure_status(m != 1 || (u[0] > 0 && c[0] > 0), &s.check))
+			return s;
+
+		T x = bootstrap(m, u, c, n, t, f, _f, p, &s.iterations);
+
+		T t0 = n ? t[n-1] : 0;
+		T I0 = integral(t0, n, t, f);
+		T q = m == 1 ? 1 : p; // a cash deposit costs 1 at time 0
+		T pv(-q), scale(fabs(q));
+		for (size_t j = 0; j < m; ++j) {
+			T w = c[j]*exp(-(u[j] <= t0 ? integral(u[j], n, t, f) : I0 + x*(u[j] - t0)));
+			pv += w;
+			scale += fabs(w);
+		}
+		s.residual = pv;
+		// Newton stops at rounding noise, a NaN forward or residual fails the test
+		s.converged = fabs(pv) <= sqrt(std::numeric_limits<T>::epsilon())*scale;
+
+		if (s.converged) {
+			_f = x;
+			s.index = static_cast<size_t>(-1);
+		}
+
+		return s;
+	}
+	template<class T>
+	inline bootstrap_status<T> bootstrap_try(const fixed_income::instrument<T>& i, const forward_curve<T>& f, T& _f, T p = 0)
+	{
+		return bootstrap_try(i.n, i.t, i.c, f.n, f.t, f.f, _f, p);
+	}
+
  } // namespace pwflat
\ No newline at end of file
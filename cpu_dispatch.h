@@ -0,0 +1,159 @@
+// cpu_dispatch.h - select vector kernels at run time from the cpu features
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include "ensure.h"
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#define PWFLAT_X86
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#elif defined(__aarch64__) || defined(_M_ARM64)
+#define PWFLAT_ARM64
+#if defined(__linux__)
+#include <sys/auxv.h>
+#endif
+#endif
+
+// compile a function for an instruction set not enabled on the command line
+#if defined(__GNUC__)
+#define PWFLAT_TARGET(x) __attribute__((target(x)))
+#else
+#define PWFLAT_TARGET(x)
+#endif
+
+namespace pwflat {
+
+	// instruction sets usable by this process, checked with the operating system
+	struct cpu_features {
+		bool avx2, fma, avx512f, avx512vl; // x86
+		bool neon, sve;                    // arm64
+	};
+
+	inline cpu_features cpu_detect(void)
+	{
+		cpu_features c = {false, false, false, false, false, false};
+
+#if defined(PWFLAT_X86) && defined(__GNUC__)
+		__builtin_cpu_init();
+		c.avx2 = __builtin_cpu_supports("avx2") != 0;
+		c.fma = __builtin_cpu_supports("fma") != 0;
+		c.avx512f = __builtin_cpu_supports("avx512f") != 0;
+		c.avx512vl = __builtin_cpu_supports("avx512vl") != 0;
+#elif defined(PWFLAT_X86) && defined(_MSC_VER)
+		int r[4];
+		__cpuid(r, 0);
+		if (r[0] >= 7) {
+			__cpuid(r, 1);
+			bool osxsave = (r[2] & (1 << 27)) != 0;
+			c.fma = (r[2] & (1 << 12)) != 0;
+			unsigned long long xcr0 = osxsave ? _xgetbv(0) : 0;
+			bool ymm = (xcr0 & 0x6) == 0x6, zmm = (xcr0 & 0xe6) == 0xe6;
+			__cpuidex(r, 7, 0);
+			c.fma = c.fma && ymm;
+			c.avx2 = ymm && (r[1] & (1 << 5)) != 0;
+			c.avx512f = zmm && (r[1] & (1 << 16)) != 0;
+			c.avx512vl = zmm && (r[1] & (1u << 31)) != 0;
+		}
+#elif defined(PWFLAT_ARM64)
+		c.neon = true; // part of the base architecture
+#if defined(__linux__) && defined(HWCAP_SVE)
+		c.sve = (getauxval(AT_HWCAP) & HWCAP_SVE) != 0;
+#endif
+#endif
+
+		return c;
+	}
+
+	// Kernel variants by instruction set.
+	// Arm64 uses the scalar kernels, which the compiler vectorizes with NEON where it can.
+	enum simd_level {
+		SIMD_SCALAR,
+		SIMD_AVX2,   // avx2 and fma, 4 doubles or 8 floats
+		SIMD_AVX512, // avx512f and avx512vl, 8 doubles or 16 floats
+	};
+
+	inline const char* simd_name(simd_level level)
+	{
+		static const char* name[] = {"scalar", "avx2", "avx512"};
+
+		return name[level];
+	}
+
+	// best level supported by the cpu and operating system
+	inline simd_level simd_support(void)
+	{
+		cpu_features c = cpu_detect();
+
+		if (c.avx512f && c.avx512vl)
+			return SIMD_AVX512;
+		if (c.avx2 && c.fma)
+			return SIMD_AVX2;
+
+		return SIMD_SCALAR;
+	}
+
+	// Level from a name, e.g. PWFLAT_SIMD=avx2, never above what is supported.
+	inline simd_level simd_parse(const char* name, simd_level support = simd_support())
+	{
+		for (int level = SIMD_SCALAR; level <= support; ++level)
+			if (name && strcmp(name, simd_name(static_cast<simd_level>(level))) == 0)
+				return static_cast<simd_level>(level);
+
+		return support;
+	}
+
+	// Level used by kernels, chosen once at startup from the PWFLAT_SIMD environment
+	// variable if set, otherwise AVX2 if supported. AVX-512 is not faster for the kernels
+	// here and can lower the clock, so it is only used when asked for.
+	inline simd_level& simd_selected(void)
+	{
+		static simd_level level = getenv("PWFLAT_SIMD") ? simd_parse(getenv("PWFLAT_SIMD"))
+			: std::min(simd_support(), SIMD_AVX2);
+
+		return level;
+	}
+	// Use level for kernels created from now on and return the previous level.
+	// Not thread safe, call at startup or from tests.
+	inline simd_level simd_select(simd_level level)
+	{
+		ensure (level <= simd_support());
+
+		simd_level prev = simd_selected();
+		simd_selected() = level;
+
+		return prev;
+	}
+
+	// Supported level with the least time for run(level), best of five runs. A wider
+	// level must be 10% faster to win so timing noise does not pick it. Kernels never
+	// call this, use it at startup, e.g. simd_select(integral_grid_fastest<double>()).
+	template<class F>
+	inline simd_level simd_fastest(const F& run, simd_level support = simd_support())
+	{
+		simd_level best = SIMD_SCALAR;
+		double tbest = std::numeric_limits<double>::max();
+
+		for (int level = SIMD_SCALAR; level <= support; ++level) {
+			double t = std::numeric_limits<double>::max();
+			for (int i = 0; i < 5; ++i) {
+				auto t0 = std::chrono::steady_clock::now();
+				run(static_cast<simd_level>(level));
+				t = std::min(t, std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count());
+			}
+			if (t < 0.9*tbest) {
+				best = static_cast<simd_level>(level);
+				tbest = t;
+			}
+		}
+
+		return best;
+	}
+
+} // namespace pwflat
@@ -0,0 +1,145 @@
+// credit_curve.h - bootstrap piecewise flat hazard rates from credit default swaps
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <cmath>
+#include <vector>
+#include "ensure.h"
+#include "bootstrap.h"
+#include "pwflat.h"
+
+namespace pwflat {
+
+	// Value to the protection buyer of a credit default swap paying spread s at
+	// times u[j] with accrual fractions a[j] and upfront p, given recovery R.
+	// Default is assumed to happen mid period so, with S[-1] = 1,
+	//
+	//	protection = (1 - R) sum_j D[j] (S[j-1] - S[j])
+	//	premium    = s sum_j a[j] D[j] (S[j] + (S[j-1] - S[j])/2)
+	//
+	// and both legs use the same discount factors D[j] = D(u[j]).
+	template<class T>
+	inline T credit_default_swap(size_t m, const T* u, const T* a, T s, T R, const forward_curve<T>& f, const hazard_curve<T>& h, T p = 0)
+	{
+		T v(-p), S0(1);
+		integral_cursor<T> If(f), Ih(h);
+
+		for (size_t j = 0; j < m; ++j) {
+			T Sj = exp(-Ih(u[j]));
+			v += exp(-If(u[j]))*(S0*((1 - R) - s*a[j]/2) - Sj*((1 - R) + s*a[j]/2));
+			S0 = Sj;
+		}
+
+		return v;
+	}
+
+	// Hazard rate past the last knot of h that makes a credit default swap worth 0.
+	// With S[j] = S(t0) exp(-x (u[j] - t0)) past the last knot t0 the value is
+	// sum c[j] S[j] - K, so bootstrap_tail solves it with one exp per remaining
+	// premium date. Scratch w holds 2m values, or m <= 256 uses the stack.
+	template<class T>
+	inline T bootstrap_hazard(size_t m, const T* u, const T* a, T s, T R, const forward_curve<T>& f, size_t n, const T* t, const T* h, T p = 0, T _h = 0, T* w = 0)
+	{
+		ensure (m && (n == 0 || u[m-1] > t[n-1]));
+		ensure (0 <= R && R < 1);
+
+		T w_[2*256];
+		if (!w) {
+			ensure (m <= 256);
+			w = w_;
+		}
+		T* tau = w;
+		T* c = w + m;
+
+		T t0 = n ? t[n-1] : 0;
+		integral_cursor<T> If(f), Ih(n, t, h);
+		T K(p), S0(1);
+		size_t k = 0; // flows past t0
+		for (size_t j = 0; j < m; ++j) {
+			T D = exp(-If(u[j]));
+			T alpha = D*((1 - R) - s*a[j]/2); // coefficient of S[j-1]
+			T beta = D*((1 - R) + s*a[j]/2);  // coefficient of S[j]
+			if (u[j] <= t0) {
+				T S1 = exp(-Ih(u[j]));
+				K -= alpha*S0 - beta*S1;
+				S0 = S1;
+			}
+			else {
+				if (k)
+					c[k-1] += alpha;
+				else
+					K -= alpha*S0;
+				tau[k] = u[j] - t0;
+				c[k] = -beta;
+				++k;
+			}
+		}
+
+		if (_h == 0)
+			_h = n ? h[n-1] : s/(1 - R); // credit triangle
+
+		return bootstrap_tail<T>(k, tau, c, K, _h, integral(t0, n, t, h));
+	}
+
+	/// <summary>Bootstrap a survival curve with piecewise flat hazard rates.</summary>
+	template<class T = double>
+	class credit_curve {
+		::pwflat::forward_curve<T> f_; // discount curve, not owned
+		T R_;
+		std::vector<T> t_;
+		std::vector<T> h_;
+		std::vector<T> w_; // bootstrap scratch, grows to the longest swap
+	public:
+		credit_curve(const ::pwflat::forward_curve<T>& f, T R)
+			: f_(f), R_(R)
+		{
+			ensure (0 <= R && R < 1);
+		}
+		virtual ~credit_curve()
+		{ }
+
+		size_t size(void) const
+		{
+			return t_.size();
+		}
+		void reset(void)
+		{
+			t_.resize(0);
+			h_.resize(0);
+		}
+		T recovery(void) const
+		{
+			return R_;
+		}
+		T maturity(void) const
+		{
+			return t_.back();
+		}
+
+		// extrapolate with the last hazard rate
+		::pwflat::hazard_curve<T> hazard_curve() const
+		{
+			return size() == 0 ? ::pwflat::hazard_curve<T>() : ::pwflat::hazard_curve<T>(t_.size(), &t_[0], &h_[0], h_.back());
+		}
+
+		/// <summary>Add a credit default swap.</summary>
+		/// <param name="m">Number of premium payments.</param>
+		/// <param name="u">Premium payment times in years.</param>
+		/// <param name="a">Accrual fractions for each premium payment.</param>
+		/// <param name="s">Running spread.</param>
+		/// <param name="p">Optional upfront paid by the protection buyer. Default is 0.</param>
+		/// <param name="_h">Optional initial guess for boostrap.</param>
+		credit_curve& add(size_t m, const T* u, const T* a, T s, T p = 0, T _h = 0)
+		{
+			if (w_.size() < 2*m)
+				w_.resize(2*m);
+			T h = bootstrap_hazard(m, u, a, s, R_, f_, t_.size(), t_.size() ? &t_[0] : 0, h_.size() ? &h_[0] : 0, p, _h, &w_[0]);
+			ensure (h == h); // Newton failed
+
+			t_.push_back(u[m - 1]);
+			h_.push_back(h);
+
+			return *this;
+		}
+	};
+
+} // namespace pwflat
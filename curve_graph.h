@@ -0,0 +1,199 @@
+// curve_graph.h - build dependent yield curves concurrently
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <algorithm>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "ensure.h"
+#include "pwflat_yield_curve.h"
+
+namespace pwflat {
+
+	// Curves are the nodes of a DAG. Each node has a function that bootstraps
+	// its yield curve given the curves it depends on. A curve can only depend on
+	// curves added before it, so node order is a topological order.
+	template<class T = double>
+	class curve_graph {
+	public:
+		typedef std::function<void(yield_curve<T>&, const curve_graph&)> build_function;
+	private:
+		struct node {
+			build_function build;
+			std::vector<size_t> in;  // curves this one depends on
+			std::vector<size_t> out; // curves that depend on this one
+			yield_curve<T> curve;
+			bool dirty;
+			unsigned long epoch; // number of times built
+			size_t wait; // inputs not yet built during build()
+		};
+		std::vector<node> node_;
+
+		// state shared by workers during build()
+		struct schedule {
+			std::mutex m;
+			std::condition_variable cv;
+			std::vector<size_t> ready;
+			size_t todo;
+			std::exception_ptr ex;
+		};
+		void work(schedule& s)
+		{
+			std::unique_lock<std::mutex> lock(s.m);
+
+			for (;;) {
+				s.cv.wait(lock, [&s] { return !s.ready.empty() || s.todo == 0 || s.ex; });
+				if (s.todo == 0 || s.ex)
+					break;
+
+				size_t i = s.ready.back();
+				s.ready.pop_back();
+
+				lock.unlock();
+				try {
+					node_[i].curve.reset();
+					node_[i].build(node_[i].curve, *this);
+				}
+				catch (...) {
+					lock.lock();
+					if (!s.ex)
+						s.ex = std::current_exception();
+					s.cv.notify_all();
+
+					break;
+				}
+				lock.lock();
+
+				node_[i].dirty = false;
+				++node_[i].epoch;
+				--s.todo;
+				for (size_t j : node_[i].out) {
+					if (node_[j].dirty && --node_[j].wait == 0)
+						s.ready.push_back(j);
+				}
+				s.cv.notify_all();
+			}
+		}
+	public:
+		curve_graph()
+		{ }
+		curve_graph(const curve_graph&) = delete;
+		curve_graph& operator=(const curve_graph&) = delete;
+		virtual ~curve_graph()
+		{ }
+
+		size_t size(void) const
+		{
+			return node_.size();
+		}
+
+		// add a curve depending on curves dep[0], ..., dep[n-1] and return its index
+		size_t add(const build_function& build, size_t n = 0, const size_t* dep = 0)
+		{
+			size_t i = node_.size();
+
+			node_.push_back(node());
+			node_[i].build = build;
+			node_[i].dirty = true;
+			node_[i].epoch = 0;
+			node_[i].wait = 0;
+			for (size_t k = 0; k < n; ++k) {
+				ensure (dep[k] < i);
+				node_[i].in.push_back(dep[k]);
+				node_[dep[k]].out.push_back(i);
+			}
+
+			return i;
+		}
+		size_t add(const build_function& build, const std::vector<size_t>& dep)
+		{
+			return add(build, dep.size(), dep.empty() ? 0 : &dep[0]);
+		}
+
+		// inputs to curve i changed
+		curve_graph& touch(size_t i)
+		{
+			ensure (i < node_.size());
+			node_[i].dirty = true;
+
+			return *this;
+		}
+		bool dirty(size_t i) const
+		{
+			ensure (i < node_.size());
+
+			return node_[i].dirty;
+		}
+
+		// changes every time curve i is rebuilt, e.g. for discount_cache::bind
+		unsigned long epoch(size_t i) const
+		{
+			ensure (i < node_.size());
+
+			return node_[i].epoch;
+		}
+
+		const yield_curve<T>& curve(size_t i) const
+		{
+			ensure (i < node_.size());
+
+			return node_[i].curve;
+		}
+		::pwflat::forward_curve<T> forward_curve(size_t i) const
+		{
+			return curve(i).forward_curve();
+		}
+
+		// rebuild dirty curves and everything downstream of them, return number of curves built
+		size_t build(size_t threads = std::thread::hardware_concurrency())
+		{
+			schedule s;
+			s.todo = 0;
+
+			for (size_t i = 0; i < node_.size(); ++i) {
+				node& ni = node_[i];
+
+				ni.wait = 0;
+				for (size_t j : ni.in) {
+					if (node_[j].dirty) {
+						ni.dirty = true;
+						++ni.wait;
+					}
+				}
+				if (ni.dirty) {
+					++s.todo;
+					if (ni.wait == 0)
+						s.ready.push_back(i);
+				}
+			}
+
+			size_t todo = s.todo;
+			if (todo == 0)
+				return 0;
+
+			// first ready curves are taken first
+			std::reverse(s.ready.begin(), s.ready.end());
+
+			if (threads == 0)
+				threads = 1;
+			if (threads > todo)
+				threads = todo;
+
+			std::vector<std::thread> pool;
+			for (size_t k = 1; k < threads; ++k)
+				pool.push_back(std::thread([this,&s] { work(s); }));
+			work(s);
+			for (auto& t : pool)
+				t.join();
+
+			if (s.ex)
+				std::rethrow_exception(s.ex);
+
+			return todo;
+		}
+	};
+
+} // namespace pwflat
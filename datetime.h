@@ -0,0 +1,12 @@
+// datetime.h - dates, calendars and day counts used by the instrument headers
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+//
+// Define FMS_DATETIME to use the fmsdatetime library checked out next to this
+// directory, otherwise the portable subset in fmsdatetime/ is used.
+#pragma once
+#if defined(FMS_DATETIME)
+#include "../fmsdatetime/datetime.h"
+#include "../fmsdatetime/calendar.h"
+#else
+#include "fmsdatetime/datetime.h"
+#endif
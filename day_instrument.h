@@ -0,0 +1,118 @@
+// day_instrument.h - cash flows on integer days since an epoch
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <cmath>
+#include <memory>
+#include <vector>
+#include "datetime.h"
+#include "ensure.h"
+#include "fixed_income.h"
+#include "discount_cache.h"
+#include "pwflat.h"
+
+namespace fixed_income {
+
+	// days since 1970-01-01
+	inline int epoch_day(const datetime::date& d)
+	{
+		return d.diffdays(datetime::date(1970, 1, 1));
+	}
+
+	// Cash flows c[i] on days d[i] since the epoch. Time in years from a valuation
+	// day v is (d[i] - v)*scale so changing the valuation date is one integer.
+	template<class T = double>
+	struct day_instrument {
+		size_t n;
+		const int* d;
+		const T* c;
+		day_instrument(size_t n_ = 0, const int* d_ = 0, const T* c_ = 0)
+			: n(n_), d(d_), c(c_)
+		{ }
+		virtual ~day_instrument()
+		{ }
+		const day_instrument& set(size_t n_, const int* d_, const T* c_)
+		{
+			n = n_;
+			d = d_;
+			c = c_;
+
+			return *this;
+		}
+	};
+
+	// day of year scaling matching date::diffyears
+	template<class T>
+	inline T year_per_day(void)
+	{
+		return static_cast<T>(1/365.25);
+	}
+
+	// Days of a fixed instrument. Assumes times are diffyears from val.
+	template<class T = double, class A = std::allocator<T>>
+	struct day_cash_flows : public day_instrument<T> {
+		std::vector<int> d_;
+		std::vector<T,A> c_;
+
+		template<class D>
+		day_cash_flows(const instrument<T,D>& i, const datetime::date& val, T scale = year_per_day<T>(), const A& alloc = A())
+			: d_(i.n), c_(i.c, i.c + i.n, alloc)
+		{
+			int v = epoch_day(val);
+
+			for (size_t j = 0; j < i.n; ++j)
+				d_[j] = v + static_cast<int>(floor(i.t[j]/scale + 0.5));
+
+			this->set(i.n, i.n ? &d_[0] : 0, i.n ? &c_[0] : 0);
+		}
+	};
+
+} // namespace fixed_income
+
+namespace pwflat {
+
+	// present value at day v of flows on or after v
+	template<class T>
+	inline T present_value(const fixed_income::day_instrument<T>& i, int v, const forward_curve<T>& f,
+		T scale = fixed_income::year_per_day<T>())
+	{
+		integral_cursor<T> I(f);
+		T pv(0);
+
+		for (size_t j = 0; j < i.n; ++j)
+			if (i.d[j] >= v)
+				pv += i.c[j]*exp(-I((i.d[j] - v)*scale));
+
+		return pv;
+	}
+	// cache days are measured from v
+	template<class T>
+	inline T present_value(const fixed_income::day_instrument<T>& i, int v, const discount_cache<T>& D)
+	{
+		T pv(0);
+
+		for (size_t j = 0; j < i.n; ++j)
+			if (i.d[j] >= v)
+				pv += i.c[j]*D(i.d[j] - v);
+
+		return pv;
+	}
+
+	// derivative of present value at day v for a parallel shift of the forward past day v0
+	template<class T>
+	inline T duration(const fixed_income::day_instrument<T>& i, int v, const forward_curve<T>& f, int v0,
+		T scale = fixed_income::year_per_day<T>())
+	{
+		integral_cursor<T> I(f);
+		T dur(0);
+
+		if (v0 < v)
+			v0 = v;
+
+		for (size_t j = 0; j < i.n; ++j)
+			if (i.d[j] > v0)
+				dur -= (i.d[j] - v0)*scale*i.c[j]*exp(-I((i.d[j] - v)*scale));
+
+		return dur;
+	}
+
+} // namespace pwflat
@@ -0,0 +1,120 @@
+// discount_cache.h - memoized discount factors at whole days
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include "ensure.h"
+#include "pwflat.h"
+
+namespace pwflat {
+
+	// Discount factors at day d from the valuation date, t = d/days_per_year.
+	// Entries are filled lazily by discount() or in bulk by fill(). Concurrent readers are safe:
+	// each entry is computed from the curve, so racing writers store the same value.
+	// bind() to a new curve epoch must not run concurrently with readers.
+	template<class T = double>
+	class discount_cache {
+		size_t n_;
+		T dpy_;
+		std::unique_ptr<std::atomic<T>[]> D_;
+		forward_curve<T> f_; // not owned
+		unsigned long epoch_;
+
+		static T empty(void)
+		{
+			return std::numeric_limits<T>::quiet_NaN();
+		}
+	public:
+		// cache days 0 to n - 1, e.g. 365*50 + 13
+		discount_cache(size_t n, T days_per_year = static_cast<T>(365.25))
+			: n_(n), dpy_(days_per_year), D_(new std::atomic<T>[n]), epoch_(0)
+		{
+			clear();
+		}
+		discount_cache(const discount_cache&) = delete;
+		discount_cache& operator=(const discount_cache&) = delete;
+
+		size_t size(void) const
+		{
+			return n_;
+		}
+		unsigned long epoch(void) const
+		{
+			return epoch_;
+		}
+		T time(int d) const
+		{
+			return d/dpy_;
+		}
+
+		// true if day d has a cached discount
+		bool cached(int d) const
+		{
+			if (d < 0 || static_cast<size_t>(d) >= n_)
+				return false;
+
+			T D = D_[d].load(std::memory_order_relaxed);
+
+			return D == D;
+		}
+
+		void clear(void)
+		{
+			for (size_t i = 0; i < n_; ++i)
+				D_[i].store(empty(), std::memory_order_relaxed);
+		}
+		// use curve f from epoch e, e.g. curve_graph::epoch(i), and invalidate if e changed
+		discount_cache& bind(const forward_curve<T>& f, unsigned long e)
+		{
+			if (e != epoch_ || f.t != f_.t || f.n != f_.n) {
+				clear();
+				epoch_ = e;
+			}
+			f_ = f;
+
+			return *this;
+		}
+		// compute all entries in one pass over the curve
+		discount_cache& fill(void)
+		{
+			integral_cursor<T> I(f_);
+
+			for (size_t i = 0; i < n_; ++i)
+				D_[i].store(exp(-I(time(static_cast<int>(i)))), std::memory_order_relaxed);
+
+			return *this;
+		}
+
+		T discount(int d) const noexcept
+		{
+			if (d < 0 || static_cast<size_t>(d) >= n_)
+				return exp(-f_.integral(time(d)));
+
+			T D = D_[d].load(std::memory_order_relaxed);
+			if (D != D) { // not cached
+				D = exp(-f_.integral(time(d)));
+				D_[d].store(D, std::memory_order_relaxed);
+			}
+
+			return D;
+		}
+		T operator()(int d) const noexcept
+		{
+			return discount(d);
+		}
+
+		// present value of cash flows c at days d
+		T present_value(size_t m, const int* d, const T* c) const
+		{
+			T pv(0);
+
+			for (size_t j = 0; j < m; ++j)
+				pv += c[j]*discount(d[j]);
+
+			return pv;
+		}
+	};
+
+} // namespace pwflat
@@ -4,17 +4,77 @@
 // #define ensure(x)
 // before including to turn ensure checking off
 //
+// ENSURE_LEVEL selects the checks compiled in:
+//	0 - none
+//	1 - ensure, the default if NDEBUG is defined
+//	2 - ensure and ensure_debug, the default otherwise
+// ENSURE_LEVEL_MIN raises it, e.g. for test drivers that check results with ensure.
+// Use ensure for cheap checks of arguments and ensure_debug for bounds and
+// ordering checks inside loops. Code that must not throw or allocate uses
+// ensure_status to record the first failed check in an ensure_failure.
+// Callers branch on its result, so it is compiled in at every level.
+//
 #pragma once
 #include <stdexcept>
+#include <string>
+
+#ifndef ENSURE_LEVEL
+#if defined(NDEBUG)
+#define ENSURE_LEVEL 1
+#else
+#define ENSURE_LEVEL 2
+#endif
+#endif
+#if defined(ENSURE_LEVEL_MIN) && ENSURE_LEVEL < ENSURE_LEVEL_MIN
+#undef ENSURE_LEVEL
+#define ENSURE_LEVEL ENSURE_LEVEL_MIN
+#endif
 
 #ifndef ensure
+#if ENSURE_LEVEL > 0
 
 #define ENSURE_HASH_(x) #x
 #define ENSURE_STRZ_(x) ENSURE_HASH_(x)
 #define ENSURE_FILE "file: " __FILE__
-#define ENSURE_FUNC "function: " __FUNCTION__
 #define ENSURE_LINE "line: " ENSURE_STRZ_(__LINE__)
+#if defined(_MSC_VER)
+#define ENSURE_FUNC "function: " __FUNCTION__
 #define ENSURE_SPOT ENSURE_FILE "\n" ENSURE_LINE "\n" ENSURE_FUNC
 #define ensure(e) if (!(e)) {throw std::runtime_error(ENSURE_SPOT "\nensure: \"" #e "\" failed");}
+#else // __FUNCTION__ is a variable, not a string literal
+#define ENSURE_SPOT ENSURE_FILE "\n" ENSURE_LINE "\nfunction: "
+#define ensure(e) if (!(e)) {throw std::runtime_error(std::string(ENSURE_SPOT) + __FUNCTION__ + "\nensure: \"" #e "\" failed");}
+#endif
 
+#else
+#define ensure(e) ((void)0)
+#endif
 #endif // ensure
+
+#if ENSURE_LEVEL > 1
+#define ensure_debug(e) ensure(e)
+#define ENSURE_NOEXCEPT
+#else
+#define ensure_debug(e) ((void)0)
+#define ENSURE_NOEXCEPT noexcept // functions whose only checks are ensure_debug
+#endif
+
+// where a check failed, file is null if none did
+struct ensure_failure {
+	const char* file;
+	int line;
+	const char* expr;
+};
+inline bool ensure_fail(ensure_failure* s, const char* file, int line, const char* expr) noexcept
+{
+	if (s && !s->file) {
+		s->file = file;
+		s->line = line;
+		s->expr = expr;
+	}
+
+	return false;
+}
+
+// true if e holds, otherwise record the first failure in s, which may be null, and return false
+#define ensure_status(e, s) ((e) || ensure_fail(s, __FILE__, __LINE__, #e))
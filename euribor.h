@@ -2,7 +2,7 @@
 // Copyright (c) 2011 KALX, LLC. All rights reserved.
 // See http://cme.com/
 #pragma once
-#include "../fmsdatetime/datetime.h"
+#include "datetime.h"
 
 enum euribor_futures_enum {
 	EDH0, // March 2020
@@ -48,47 +48,47 @@ enum euribor_futures_enum {
 };
 
 static struct  {
-	month_of_year month;
+	datetime::month_of_year month;
 	unsigned int year; // last digit of year
 } euribor_futures_data[] = {
-	{MONTH_MAR,0},
-	{MONTH_JUN,0},
-	{MONTH_SEP,0},
-	{MONTH_DEC,0},
-	{MONTH_MAR,1},
-	{MONTH_JUN,1},
-	{MONTH_SEP,1},
-	{MONTH_DEC,1},
-	{MONTH_MAR,2},
-	{MONTH_JUN,2},
-	{MONTH_SEP,2},
-	{MONTH_DEC,2},
-	{MONTH_MAR,3},
-	{MONTH_JUN,3},
-	{MONTH_SEP,3},
-	{MONTH_DEC,3},
-	{MONTH_MAR,4},
-	{MONTH_JUN,4},
-	{MONTH_SEP,4},
-	{MONTH_DEC,4},
-	{MONTH_MAR,5},
-	{MONTH_JUN,5},
-	{MONTH_SEP,5},
-	{MONTH_DEC,5},
-	{MONTH_MAR,6},
-	{MONTH_JUN,6},
-	{MONTH_SEP,6},
-	{MONTH_DEC,6},
-	{MONTH_MAR,7},
-	{MONTH_JUN,7},
-	{MONTH_SEP,7},
-	{MONTH_DEC,7},
-	{MONTH_MAR,8},
-	{MONTH_JUN,8},
-	{MONTH_SEP,8},
-	{MONTH_DEC,8},
-	{MONTH_MAR,9},
-	{MONTH_JUN,9},
-	{MONTH_SEP,9},
-	{MONTH_DEC,9},
+	{datetime::MONTH_MAR,0},
+	{datetime::MONTH_JUN,0},
+	{datetime::MONTH_SEP,0},
+	{datetime::MONTH_DEC,0},
+	{datetime::MONTH_MAR,1},
+	{datetime::MONTH_JUN,1},
+	{datetime::MONTH_SEP,1},
+	{datetime::MONTH_DEC,1},
+	{datetime::MONTH_MAR,2},
+	{datetime::MONTH_JUN,2},
+	{datetime::MONTH_SEP,2},
+	{datetime::MONTH_DEC,2},
+	{datetime::MONTH_MAR,3},
+	{datetime::MONTH_JUN,3},
+	{datetime::MONTH_SEP,3},
+	{datetime::MONTH_DEC,3},
+	{datetime::MONTH_MAR,4},
+	{datetime::MONTH_JUN,4},
+	{datetime::MONTH_SEP,4},
+	{datetime::MONTH_DEC,4},
+	{datetime::MONTH_MAR,5},
+	{datetime::MONTH_JUN,5},
+	{datetime::MONTH_SEP,5},
+	{datetime::MONTH_DEC,5},
+	{datetime::MONTH_MAR,6},
+	{datetime::MONTH_JUN,6},
+	{datetime::MONTH_SEP,6},
+	{datetime::MONTH_DEC,6},
+	{datetime::MONTH_MAR,7},
+	{datetime::MONTH_JUN,7},
+	{datetime::MONTH_SEP,7},
+	{datetime::MONTH_DEC,7},
+	{datetime::MONTH_MAR,8},
+	{datetime::MONTH_JUN,8},
+	{datetime::MONTH_SEP,8},
+	{datetime::MONTH_DEC,8},
+	{datetime::MONTH_MAR,9},
+	{datetime::MONTH_JUN,9},
+	{datetime::MONTH_SEP,9},
+	{datetime::MONTH_DEC,9},
 };
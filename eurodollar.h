@@ -2,7 +2,8 @@
 // Copyright (c) 2011 KALX, LLC. All rights reserved.
 // See http://cme.com/
 #pragma once
-#include "../fmsdatetime/datetime.h"
+#include "datetime.h"
+#include "ensure.h"
 
 // index of closest contract past given days
 inline int 
@@ -31,3 +32,28 @@ eurodollar_first_contract(const datetime::date& d, int days)
 	return ordinal;
 }
 
+// IMM start date of the ordinal contract (1 is front) trading on set
+// Contracts start trading 2 business days before the Last Trading Day of the prior contract.
+inline datetime::date
+eurodollar_effective(const datetime::date& set, unsigned int ordinal)
+{
+	ensure (ordinal > 0);
+
+	int y, m, d;
+	set.localtime(&y, &m, &d);
+
+	// round up to month divisible by 3
+	datetime::date eff(y, 3*(1 + (m - 1)/3), 15, 0, 0, 0);
+	eff.imm(3, datetime::DAY_WED);
+
+	// eff is the front contract unless it has stopped trading
+	if (!(set < datetime::date(eff).incr(-2, datetime::UNIT_DAYS, datetime::CALENDAR_CMM)))
+		++ordinal;
+
+	if (ordinal > 1) {
+		eff.incr(3*(ordinal - 1), datetime::UNIT_MONTHS);
+		eff.imm(3, datetime::DAY_WED);
+	}
+
+	return eff;
+}
@@ -2,50 +2,55 @@
 // Copyright (c) 2011 KALX, LLC. All rights reserved.
 // See http://cme.com/
 #pragma once
-#include "../fmsdatetime/calendar.h"
+#include "datetime.h"
+#include "eurodollar.h"
 #include "forward_rate_agreement.h"
+#include "futures_strip.h"
 
 namespace fixed_income {
 
-	class eurodollar_futures : public forward_rate_agreement {
+	// CME Group eurodollar futures as a forward rate agreement on the convexity adjusted rate
+	// a and sigma are Hull-White parameters for the convexity adjustment
+	template<class T = double, class A = std::allocator<T>>
+	class eurodollar_futures : public forward_rate_agreement<T,A> {
 	protected:
 		unsigned int ordinal_;
+		T a_, sigma_;
 	public:
-		// CME Group eurodollar futures 
-		eurodollar_futures(unsigned int ordinal)
-			: ordinal_(ordinal), forward_rate_agreement(3, datetime::UNIT_MONTHS, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_CMM)
+		eurodollar_futures(unsigned int ordinal, T a = 0, T sigma = 0, const A& alloc = A())
+			: forward_rate_agreement<T,A>(date(), 3, datetime::UNIT_MONTHS, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_CMM, alloc),
+			  ordinal_(ordinal), a_(a), sigma_(sigma)
 		{
 			ensure (ordinal > 0);
 		}
 
-		eurodollar_futures& fix(const datetime::date& set, double price) //???include convexity???
+		const eurodollar_futures& fix(const datetime::date& set, T price)
 		{
-			// convexity???
-			int y, m, d;
-			set.localtime(&y, &m, &d);
-
-			// round up to month divisible by 3
-			datetime::date eff(y, 3*(1 + (m - 1)/3), 15, 0, 0, 0); // 11AM???
-			eff.imm(3, datetime::DAY_WED);
-
-			// contracts start trading 2 days before Last Trading Day of prior contract
-			if (set < datetime::date(eff).incr(-2, datetime::UNIT_DAYS, datetime::CALENDAR_CMM)) {
-				// eff is front contract
-				if (ordinal_ > 1) {
-					eff.incr(3*(ordinal_ - 1), datetime::UNIT_MONTHS);
-					eff.imm(3, datetime::DAY_WED);
-				}
-			}
-			else {
-				// eff is previous contract LastTradingDay
-				eff.incr(3*ordinal_, datetime::UNIT_MONTHS);
-				eff.imm(3, datetime::DAY_WED);
-			}
-
-			forward_rate_agreement::valuation(set, eff, 1 - price/100);
+			this->eff_ = eurodollar_effective(set, ordinal_);
+
+			auto s = schedules<T>().get(this->eff_, 0, this->count_, this->unit_, datetime::FREQ_NONE, this->roll_, this->cal_, this->dcb_);
+			T t1 = static_cast<T>(this->eff_.diffyears(set));
+			T t2 = t1 + s->t[1];
+
+			forward_rate_agreement<T,A>::fix(set, futures_rate(price) - futures_convexity(t1, t2, a_, sigma_));
 
 			return *this;
 		}
 	};
 
-} // namespace instrument
\ No newline at end of file
+	// Start, end and growth 1 + r dcf of the first m contracts given prices.
+	// Use pwflat::bootstrap_strip to add them to a curve.
+	template<class T>
+	inline void eurodollar_strip(const datetime::date& set, size_t m, const T* price,
+		T* u0, T* u1, T* d, T a = 0, T sigma = 0)
+	{
+		for (size_t k = 0; k < m; ++k) {
+			eurodollar_futures<T> edf(static_cast<unsigned int>(k + 1), a, sigma);
+			edf.fix(set, price[k]);
+			u0[k] = edf.t[0];
+			u1[k] = edf.t[1];
+			d[k] = edf.c[1];
+		}
+	}
+
+} // namespace fixed_income
\ No newline at end of file
@@ -0,0 +1,97 @@
+// exposure.h - forward values of a portfolio on a grid of observation dates
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "ensure.h"
+#include "parallel.h"
+#include "pwflat.h"
+
+namespace pwflat {
+
+	// Discount to the sorted unique union of all observation dates and cash flow times.
+	template<class T = double>
+	class discount_grid {
+		std::vector<T> u_;
+		std::vector<T> D_;
+	public:
+		discount_grid(size_t ns, const T* s, size_t ni, const fixed_income::instrument<T>* i, const forward_curve<T>& f)
+		{
+			size_t m = ns;
+			for (size_t k = 0; k < ni; ++k)
+				m += i[k].n;
+
+			u_.reserve(m);
+			u_.insert(u_.end(), s, s + ns);
+			for (size_t k = 0; k < ni; ++k)
+				u_.insert(u_.end(), i[k].t, i[k].t + i[k].n);
+			std::sort(u_.begin(), u_.end());
+			u_.erase(std::unique(u_.begin(), u_.end()), u_.end());
+
+			// one merged pass over curve knots and grid times
+			D_.resize(u_.size());
+			integral_cursor<T> I(f);
+			for (size_t j = 0; j < u_.size(); ++j)
+				D_[j] = exp(-I(u_[j]));
+		}
+
+		size_t size(void) const
+		{
+			return u_.size();
+		}
+		const T* time(void) const
+		{
+			return u_.empty() ? 0 : &u_[0];
+		}
+		// t must be a grid time
+		T discount(T t) const
+		{
+			size_t j = std::lower_bound(u_.begin(), u_.end(), t) - u_.begin();
+			ensure (j < u_.size() && u_[j] == t);
+
+			return D_[j];
+		}
+	};
+
+	// Forward value at sorted observation dates s of the cash flows strictly after each date
+	//
+	//	v(s, i) = sum_{u_j > s} c_j D(s, u_j), D(s, u) = exp(-(I(u) - I(s)))
+	//
+	// for instruments with increasing cash flow times. The caller owns v, an ns x ni date major matrix.
+	template<class T>
+	inline void exposure(size_t ns, const T* s, size_t ni, const fixed_income::instrument<T>* i,
+		const discount_grid<T>& D, T* v, size_t threads = std::thread::hardware_concurrency())
+	{
+		ensure (std::is_sorted(s, s + ns));
+
+		std::vector<T> Ds(ns);
+		for (size_t k = 0; k < ns; ++k)
+			Ds[k] = D.discount(s[k]);
+
+		parallel::for_range(ni, [&](size_t b, size_t e) {
+			for (size_t l = b; l < e; ++l) {
+				const fixed_income::instrument<T>& il = i[l];
+				ensure (std::is_sorted(il.t, il.t + il.n));
+				T pv(0);
+				size_t j = il.n;
+
+				// walk flows and dates backwards accumulating sum_{u_j > s} c_j D(u_j)
+				for (size_t k = ns; k--; ) {
+					while (j && il.t[j - 1] > s[k]) {
+						--j;
+						pv += il.c[j]*D.discount(il.t[j]);
+					}
+					v[k*ni + l] = pv/Ds[k];
+				}
+			}
+		}, threads);
+	}
+	template<class T>
+	inline void exposure(size_t ns, const T* s, size_t ni, const fixed_income::instrument<T>* i,
+		const forward_curve<T>& f, T* v, size_t threads = std::thread::hardware_concurrency())
+	{
+		exposure(ns, s, ni, i, discount_grid<T>(ns, s, ni, i, f), v, threads);
+	}
+
+} // namespace pwflat
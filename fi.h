@@ -3,18 +3,26 @@
 #pragma once
 #include <algorithm>
 #include <functional>
+#include <iterator>
 #include <limits>
 #include <numeric>
 
+#if defined(_MSC_VER)
 #pragma warning(disable: 4100)
+#endif
 
 namespace functional {
 
 	// iterator with function applied to each item
 	template<class F, class I>
-	class apply_iterator : public std::iterator<std::input_iterator_tag, typename std::iterator_traits<I>::value_type> {
-	protected:
+	class apply_iterator {
+	public:
+		typedef std::input_iterator_tag iterator_category;
 		typedef typename std::iterator_traits<I>::value_type value_type;
+		typedef typename std::iterator_traits<I>::difference_type difference_type;
+		typedef value_type* pointer;
+		typedef value_type reference;
+	protected:
 		F f_;
 		I i_;
 	public:
@@ -77,7 +85,7 @@ namespace functional {
 	template<class F, class G>
 	inline auto extrapolate(const F& f, const G& g) -> std::function<decltype(f(0))(decltype(f(0)))> 
 	{
-		typedef typename decltype(f(0)) T;
+		typedef decltype(f(0)) T;
 
 		return [f,g](T t) -> T { return t <= domain_max(f) ? f(t) : g(t); };
 	}
@@ -86,7 +94,7 @@ namespace functional {
 	template<class F>
 	inline auto integral(const F& f, size_t n = 100) -> std::function<decltype(f(0))(decltype(f(0)))> 
 	{
-		typedef typename decltype(f(0)) T;
+		typedef decltype(f(0)) T;
 
 		return [f,n](T t) -> T
 		{
@@ -156,7 +164,7 @@ namespace functional {
 	template<class T>
 	std::function<T(T)> integral(const piecewise_constant<T>& F, T _f = 0)
 	{
-		return [F](T u) -> T {
+		return [F,_f](T u) -> T {
 			size_t n = F.n;
 			const T* t = F.t;
 			const T* f = F.f;
@@ -179,7 +187,7 @@ namespace functional {
 template<class F, class G, class Op>
 inline auto operator_op(const F& f, const G& g, Op op) -> std::function<decltype(op(f(0),g(0)))(decltype(f(0)))>
 {
-	typedef typename decltype(f(0)) T;
+	typedef decltype(f(0)) T;
 
 	return [f,g,op](T t) -> T { return op(f(t), g(t)); };
 }
@@ -212,7 +220,7 @@ namespace fi {
 	template<class F>
 	inline auto spot(const F& f) -> std::function<decltype(f(0))(decltype(f(0)))>
 	{
-		typedef typename decltype(f(0)) T;
+		typedef decltype(f(0)) T;
 
 		return [f](T t) -> T { return 1 + t == 1 ? f(t) : functional::integral(f)(t)/t; };
 	}
@@ -220,7 +228,7 @@ namespace fi {
 	template<class F>
 	inline auto discount(const F& f) -> std::function<decltype(f(0))(decltype(f(0)))>
 	{
-		typedef typename decltype(f(0)) T;
+		typedef decltype(f(0)) T;
 
 		return [f](T t) -> T { return exp(-functional::integral(f)(t)); };
 	}
@@ -229,7 +237,7 @@ namespace fi {
 	template<class D>
 	inline auto present_value(const D& d) -> std::function<decltype(d(0))(size_t, const decltype(d(0))*, const decltype(d(0))*)>
 	{
-		typedef typename decltype(d(0)) T;
+		typedef decltype(d(0)) T;
 
 		return [d](size_t n, const T* t, const T* c) { 
 			return std::inner_product(c, c + n, functional::apply(d, t), (T)0);
@@ -240,7 +248,7 @@ namespace fi {
 	template<class D>
 	inline auto duration(const D& d, decltype(d(0)) t0 = 0) -> std::function<decltype(d(0))(size_t, const decltype(d(0))*, const decltype(d(0))*)>
 	{
-		typedef typename decltype(d(0)) T;
+		typedef decltype(d(0)) T;
 
 		return [d,t0](size_t n, const T* t, const T* c) -> T { 
 			T dur(0);
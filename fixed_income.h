@@ -1,6 +1,7 @@
 // fixed_income.h - fixed income routines
 // Copyright (c) 2013 KALX, LLC. All rights reserved. No warranty made.
 #pragma once
+#include <cstddef>
 
 namespace fixed_income {
 
@@ -0,0 +1,3 @@
+// calendar.h - calendars are part of datetime.h in the portable subset
+#pragma once
+#include "datetime.h"
@@ -0,0 +1,274 @@
+// datetime.h - portable subset of the fmsdatetime library
+// Copyright (c) 2013 KALX, LLC. All rights reserved. No warranty made.
+//
+// Only the part of the interface used by the instrument headers is provided.
+// Holiday calendars only know about weekends. diffyears is actual/365.25.
+#pragma once
+
+namespace datetime {
+
+	enum time_unit {
+		UNIT_DAYS,
+		UNIT_WEEKS,
+		UNIT_MONTHS,
+		UNIT_YEARS,
+		UNIT_DAY = UNIT_DAYS,
+		UNIT_WEEK = UNIT_WEEKS,
+		UNIT_MONTH = UNIT_MONTHS,
+		UNIT_YEAR = UNIT_YEARS
+	};
+
+	enum day_count_basis {
+		DCB_ACTUAL_360,
+		DCB_ACTUAL_365,
+		DCB_ACTUAL_ACTUAL,
+		DCB_30U_360
+	};
+
+	enum roll_convention {
+		ROLL_NONE,
+		ROLL_FOLLOWING,
+		ROLL_PREVIOUS,
+		ROLL_MODIFIED_FOLLOWING,
+		ROLL_MODIFIED_PREVIOUS
+	};
+
+	enum payment_frequency {
+		FREQ_NONE = 0,
+		FREQ_ANNUALLY = 1,
+		FREQ_SEMIANNUALLY = 2,
+		FREQ_QUARTERLY = 4,
+		FREQ_MONTHLY = 12
+	};
+
+	enum day_of_week {
+		DAY_SUN,
+		DAY_MON,
+		DAY_TUE,
+		DAY_WED,
+		DAY_THU,
+		DAY_FRI,
+		DAY_SAT
+	};
+
+	enum month_of_year {
+		MONTH_JAN = 1,
+		MONTH_FEB,
+		MONTH_MAR,
+		MONTH_APR,
+		MONTH_MAY,
+		MONTH_JUN,
+		MONTH_JUL,
+		MONTH_AUG,
+		MONTH_SEP,
+		MONTH_OCT,
+		MONTH_NOV,
+		MONTH_DEC
+	};
+
+	// calendars are identified by a small integer
+	typedef int holiday_calendar;
+	enum {
+		CALENDAR_NONE = 0, // every day is a business day
+		CALENDAR_WEEKENDS,
+		CALENDAR_CMM       // stand-in for the CME calendar
+	};
+
+	// calendar date stored as days since 1970-01-01
+	class date {
+		int d_;
+
+		static int days_from_civil(int y, int m, int d)
+		{
+			y -= m <= 2;
+			int era = (y >= 0 ? y : y - 399)/400;
+			int yoe = y - era*400;
+			int doy = (153*(m + (m > 2 ? -3 : 9)) + 2)/5 + d - 1;
+			int doe = yoe*365 + yoe/4 - yoe/100 + doy;
+
+			return era*146097 + doe - 719468;
+		}
+		static void civil_from_days(int z, int* y, int* m, int* d)
+		{
+			z += 719468;
+			int era = (z >= 0 ? z : z - 146096)/146097;
+			int doe = z - era*146097;
+			int yoe = (doe - doe/1460 + doe/36524 - doe/146096)/365;
+			int doy = doe - (365*yoe + yoe/4 - yoe/100);
+			int mp = (5*doy + 2)/153;
+
+			*d = doy - (153*mp + 2)/5 + 1;
+			*m = mp + (mp < 10 ? 3 : -9);
+			*y = yoe + era*400 + (*m <= 2);
+		}
+		static int days_in_month(int y, int m)
+		{
+			static const int dim[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+			bool leap = (y%4 == 0 && y%100 != 0) || y%400 == 0;
+
+			return m == 2 && leap ? 29 : dim[m - 1];
+		}
+	public:
+		date()
+			: d_(0)
+		{ }
+		date(int y, int m, int d, int = 0, int = 0, int = 0)
+			: d_(days_from_civil(y, m, d))
+		{ }
+
+		int year() const
+		{
+			int y, m, d;
+			localtime(&y, &m, &d);
+
+			return y;
+		}
+		int month() const
+		{
+			int y, m, d;
+			localtime(&y, &m, &d);
+
+			return m;
+		}
+		int day() const
+		{
+			int y, m, d;
+			localtime(&y, &m, &d);
+
+			return d;
+		}
+		void localtime(int* y, int* m, int* d) const
+		{
+			civil_from_days(d_, y, m, d);
+		}
+		day_of_week wday() const
+		{
+			return static_cast<day_of_week>(((d_%7) + 11)%7); // 1970-01-01 was a Thursday
+		}
+
+		bool is_business_day(holiday_calendar cal) const
+		{
+			return cal == CALENDAR_NONE || (wday() != DAY_SAT && wday() != DAY_SUN);
+		}
+
+		// business days if cal is not CALENDAR_NONE and unit is days
+		date& incr(int n, time_unit unit, holiday_calendar cal = CALENDAR_NONE)
+		{
+			if (unit == UNIT_DAYS && cal != CALENDAR_NONE) {
+				int s = n < 0 ? -1 : 1;
+				for (; n; n -= s) {
+					do {
+						d_ += s;
+					} while (!is_business_day(cal));
+				}
+
+				return *this;
+			}
+			if (unit == UNIT_DAYS || unit == UNIT_WEEKS) {
+				d_ += n*(unit == UNIT_WEEKS ? 7 : 1);
+
+				return *this;
+			}
+
+			int y, m, d;
+			localtime(&y, &m, &d);
+			int mm = 12*y + (m - 1) + n*(unit == UNIT_YEARS ? 12 : 1);
+			y = (mm >= 0 ? mm : mm - 11)/12;
+			m = mm - 12*y + 1;
+			if (d > days_in_month(y, m))
+				d = days_in_month(y, m);
+			d_ = days_from_civil(y, m, d);
+
+			return *this;
+		}
+		date& adjust(roll_convention roll, holiday_calendar cal)
+		{
+			if (roll == ROLL_NONE || is_business_day(cal))
+				return *this;
+
+			int m = month();
+			date d(*this);
+			int s = (roll == ROLL_PREVIOUS || roll == ROLL_MODIFIED_PREVIOUS) ? -1 : 1;
+			do {
+				d.d_ += s;
+			} while (!d.is_business_day(cal));
+			if ((roll == ROLL_MODIFIED_FOLLOWING || roll == ROLL_MODIFIED_PREVIOUS) && d.month() != m) {
+				d = *this;
+				do {
+					d.d_ -= s;
+				} while (!d.is_business_day(cal));
+			}
+			*this = d;
+
+			return *this;
+		}
+		// n-th given day of week in the current month
+		date& imm(int n, day_of_week dw)
+		{
+			int y, m, d;
+			localtime(&y, &m, &d);
+			d_ = days_from_civil(y, m, 1);
+			d_ += (7 + dw - wday())%7 + 7*(n - 1);
+
+			return *this;
+		}
+
+		int diffdays(const date& d) const
+		{
+			return d_ - d.d_;
+		}
+		double diffyears(const date& d) const
+		{
+			return diffdays(d)/365.25;
+		}
+		// day count fraction from d0 to this date
+		double diff_dcb(const date& d0, day_count_basis dcb) const
+		{
+			switch (dcb) {
+			case DCB_ACTUAL_360:
+				return diffdays(d0)/360.;
+			case DCB_ACTUAL_365:
+				return diffdays(d0)/365.;
+			case DCB_30U_360: {
+				int y0, m0, dd0, y1, m1, dd1;
+				d0.localtime(&y0, &m0, &dd0);
+				localtime(&y1, &m1, &dd1);
+				if (dd0 == 31)
+					dd0 = 30;
+				if (dd1 == 31 && dd0 == 30)
+					dd1 = 30;
+
+				return (360*(y1 - y0) + 30*(m1 - m0) + (dd1 - dd0))/360.;
+			}
+			default:
+				return diffyears(d0);
+			}
+		}
+
+		bool operator==(const date& d) const
+		{
+			return d_ == d.d_;
+		}
+		bool operator!=(const date& d) const
+		{
+			return d_ != d.d_;
+		}
+		bool operator<(const date& d) const
+		{
+			return d_ < d.d_;
+		}
+		bool operator<=(const date& d) const
+		{
+			return d_ <= d.d_;
+		}
+		bool operator>(const date& d) const
+		{
+			return d_ > d.d_;
+		}
+		bool operator>=(const date& d) const
+		{
+			return d_ >= d.d_;
+		}
+	};
+
+} // namespace datetime
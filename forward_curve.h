@@ -3,6 +3,7 @@
 #pragma once
 #include <cmath>
 #include <limits>
+#include "fixed_income.h"
 
 namespace fixed_income {
 
@@ -36,4 +37,39 @@ namespace fixed_income {
 		return fabs(t) < sqrt(std::numeric_limits<double>::epsilon()) ? f(t) : f.integral(t)/t;
 	}
 
+	// present value of cash flows c at times u for any curve, e.g. pwlinear or monotone_convex
+	template<class T, class F>
+	inline F present_value(size_t m, const T* u, const F* c, const fixed_income::forward_curve<T,F>& f)
+	{
+		F pv(0);
+
+		for (size_t j = 0; j < m; ++j)
+			pv += c[j]*discount(f, u[j]);
+
+		return pv;
+	}
+	template<class T, class F, class D>
+	inline F present_value(const fixed_income::instrument<T,D>& i, const fixed_income::forward_curve<T,F>& f)
+	{
+		return present_value(i.n, i.t, i.c, f);
+	}
+
+	// derivative of present value with respect to a parallel shift of the forward after u0
+	template<class T, class F>
+	inline F duration(size_t m, const T* u, const F* c, const fixed_income::forward_curve<T,F>& f, T u0 = 0)
+	{
+		F dur(0);
+
+		for (size_t j = 0; j < m; ++j)
+			if (u[j] > u0)
+				dur -= (u[j] - u0)*c[j]*discount(f, u[j]);
+
+		return dur;
+	}
+	template<class T, class F, class D>
+	inline F duration(const fixed_income::instrument<T,D>& i, const fixed_income::forward_curve<T,F>& f, T u0 = 0)
+	{
+		return duration(i.n, i.t, i.c, f, u0);
+	}
+
 } // namespace fixed_income
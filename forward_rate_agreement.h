@@ -1,41 +1,46 @@
 // forward_rate_agreement.h - cash deposit indicative data and cash flows
 // Copyright (c) 2011 KALX, LLC. All rights reserved.
 #pragma once
-#include "../fmsdatetime/datetime.h"
+#include "datetime.h"
+#include <memory>
+#include <vector>
 #include "fixed_income.h"
+#include "schedule_cache.h"
 
 using datetime::date;
 using datetime::holiday_calendar;
 
 namespace fixed_income {
 
-	template<class T = double>
+	// A is the allocator for cash flow storage, e.g. arena_allocator<T>
+	template<class T = double, class A = std::allocator<T>>
 	struct forward_rate_agreement : public instrument<T,date> {
-		std::vector<T> t_;
-		std::vector<T> c_;
+		std::vector<T,A> t_;
+		std::vector<T,A> c_;
 		// indicative data
 		date eff_;
-		int count_; time_unit unit_; // e.g., 2, UNIT_WEEKS
-		day_count_basis dcb_;
-		roll_convention roll_;
+		int count_; datetime::time_unit unit_; // e.g., 2, datetime::UNIT_WEEKS
+		datetime::day_count_basis dcb_;
+		datetime::roll_convention roll_;
 		holiday_calendar cal_;
 		
 		// typical cash deposit conventions
 /*		forward_rate_agreement()
 		:   fixed_income_vector<IF>(2),
 			fixed_income<IF,IF>(&t_[0], &t_[0] + t_.size(), &c_[0]),
-			count_(3), unit_(UNIT_MONTHS), 
-			dcb_(DCB_ACTUAL_360), 
-			roll_(ROLL_MODIFIED_FOLLOWING), 
-			cal_(CALENDAR_NONE)
+			count_(3), unit_(datetime::UNIT_MONTHS), 
+			dcb_(datetime::DCB_ACTUAL_360), 
+			roll_(datetime::ROLL_MODIFIED_FOLLOWING), 
+			cal_(datetime::CALENDAR_NONE)
 		{ }
 */		forward_rate_agreement(
 			const date& eff,
-			int count, time_unit unit,
-			day_count_basis dcb = DCB_ACTUAL_360,
-			roll_convention roll = ROLL_MODIFIED_FOLLOWING,
-			const holiday_calendar& cal = CALENDAR_NONE)
-		:   t_(2), c_(2),
+			int count, datetime::time_unit unit,
+			datetime::day_count_basis dcb = datetime::DCB_ACTUAL_360,
+			datetime::roll_convention roll = datetime::ROLL_MODIFIED_FOLLOWING,
+			const holiday_calendar& cal = datetime::CALENDAR_NONE,
+			const A& alloc = A())
+		:   t_(2, T(0), alloc), c_(2, T(0), alloc),
 			eff_(eff), count_(count), unit_(unit),
 			dcb_(dcb), roll_(roll), cal_(cal)
 		{
@@ -47,20 +52,21 @@ namespace fixed_income {
 		// compiler generated copy constructor, assignment, destructor
 
 		// create cash flows given settlement, effective, and forward rate
-		const forward_rate_agreement<T>& fix(const date& val, T forward)
+		const forward_rate_agreement& fix(const date& val, T forward)
 		{
-			t_[0] = eff_.diffyears(val);
+			auto s = schedules<T>().get(eff_, 0, count_, unit_, datetime::FREQ_NONE, roll_, cal_, dcb_);
+			T t0 = static_cast<T>(eff_.diffyears(val));
+
+			t_[0] = t0;
 			ensure(t_[0] >= 0);
 			c_[0] = -1;
 
-			datetime::date d(eff_);
-			d.incr(count_, unit_).adjust(roll_, cal_);
-			t_[1] = d.diffyears(eff_);
-			c_[1] = 1 + forward*d.diff_dcb(eff_, dcb_);
+			t_[1] = t0 + s->t[1];
+			c_[1] = 1 + forward*s->dcf[1];
 
 			ensure (c_[1] > 0); // otherwise arbitrage exists
 
-			set(2, &t_[0], &c_[0]);
+			this->set(2, &t_[0], &c_[0]);
 
 			return *this;
 		}
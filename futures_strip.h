@@ -0,0 +1,97 @@
+// futures_strip.h - bootstrap a strip of short term interest rate futures
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <cmath>
+#include "ensure.h"
+#include "pwflat.h"
+
+namespace fixed_income {
+
+	// rate implied by a futures quote, e.g. 97.5 -> 0.025
+	template<class T>
+	inline T futures_rate(T price)
+	{
+		return 1 - price/100;
+	}
+
+	// Hull-White futures rate minus forward rate for the period [t1, t2]
+	//
+	//	B(t1,t2)/(t2 - t1) (B(t1,t2)(1 - exp(-2 a t1)) + 2 a B(0,t1)^2) sigma^2/(4 a)
+	//
+	// where B(s,t) = (1 - exp(-a(t - s)))/a. This is exact for continuously compounded
+	// rates and the usual approximation for simple rates. Ho-Lee limit when a = 0.
+	template<class T>
+	inline T futures_convexity(T t1, T t2, T a, T sigma)
+	{
+		ensure (0 <= t1 && t1 < t2);
+		ensure (a >= 0);
+
+		if (a == 0)
+			return sigma*sigma*t1*t2/2;
+
+		T B12 = (1 - exp(-a*(t2 - t1)))/a;
+		T B01 = (1 - exp(-a*t1))/a;
+
+		return B12/(t2 - t1)*(B12*(1 - exp(-2*a*t1)) + 2*a*B01*B01)*sigma*sigma/(4*a);
+	}
+
+} // namespace fixed_income
+
+namespace pwflat {
+
+	// Periods start before they end and are sorted by start and end, the first ends past t0 and d > 0.
+	template<class T>
+	inline void check_strip(size_t m, const T* u0, const T* u1, const T* d, T t0)
+	{
+		for (size_t k = 0; k < m; ++k) {
+			ensure (u0[k] < u1[k] && u1[k] > (k ? u1[k-1] : t0));
+			ensure (k == 0 || u0[k] >= u0[k-1]);
+			ensure (d[k] > 0);
+		}
+	}
+
+	// Bootstrap a strip of periods [u0[k], u1[k]] with growth d[k] = D(u0[k])/D(u1[k]), e.g. 1 + r dcf,
+	// onto the curve n, t, f in one pass. Knot k is written to t[n + k], f[n + k] and n + m is returned.
+	// Periods are sorted by start and end. A period starting before the last knot (overlap)
+	// uses the discount to its start from the curve built so far. A period starting on or past
+	// the last knot (adjacent or underlap) extends the flat forward back to the last knot,
+	// the same as bootstrap2. t and f are not written if a period fails check_strip.
+	template<class T>
+	inline size_t bootstrap_strip(size_t m, const T* u0, const T* u1, const T* d, size_t n, T* t, T* f)
+	{
+		T t0 = n ? t[n-1] : 0;
+		check_strip(m, u0, u1, d, t0);
+
+		// closed form part: knots and log growth
+		for (size_t k = 0; k < m; ++k) {
+			t[n + k] = u1[k];
+			f[n + k] = log(d[k]);
+		}
+
+		T I0 = integral(t0, n, t, f); // int_0^t0 f
+
+		// cursor for int_0^u0 over the knots built so far
+		size_t i = 0;
+		T s = 0, Is = 0;
+
+		for (size_t k = 0; k < m; ++k) {
+			if (u0[k] < t0) { // overlap
+				while (t[i] <= u0[k]) {
+					Is += f[i]*(t[i] - s);
+					s = t[i];
+					++i;
+				}
+				f[n + k] = (Is + f[i]*(u0[k] - s) + f[n + k] - I0)/(u1[k] - t0);
+			}
+			else { // adjacent or underlap
+				f[n + k] /= u1[k] - u0[k];
+			}
+
+			I0 += f[n + k]*(u1[k] - t0);
+			t0 = u1[k];
+		}
+
+		return n + m;
+	}
+
+} // namespace pwflat
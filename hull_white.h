@@ -0,0 +1,165 @@
+// hull_white.h - one factor Hull-White Monte Carlo fitted to a piecewise flat forward curve
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <cmath>
+#include <cstdint>
+#include "ensure.h"
+#include "parallel.h"
+#include "pwflat.h"
+
+namespace pwflat {
+
+	namespace rng {
+
+		// Counter based random numbers: the same (seed, counter) always gives the same value,
+		// so paths do not depend on how they are split over threads.
+		inline uint64_t mix(uint64_t x)
+		{
+			// splitmix64 finalizer
+			x += 0x9E3779B97F4A7C15ull;
+			x = (x ^ (x >> 30))*0xBF58476D1CE4E5B9ull;
+			x = (x ^ (x >> 27))*0x94D049BB133111EBull;
+
+			return x ^ (x >> 31);
+		}
+		// uniform in (0, 1)
+		template<class T>
+		inline T uniform(uint64_t seed, uint64_t counter)
+		{
+			return static_cast<T>(((mix(seed ^ mix(counter)) >> 11) + 0.5)/9007199254740992.);
+		}
+		// standard normal using Box-Muller on counters 2*counter and 2*counter + 1
+		template<class T>
+		inline T normal(uint64_t seed, uint64_t counter)
+		{
+			double u1 = uniform<double>(seed, 2*counter);
+			double u2 = uniform<double>(seed, 2*counter + 1);
+
+			return static_cast<T>(sqrt(-2*log(u1))*cos(6.283185307179586*u2));
+		}
+
+	} // namespace rng
+
+	// r(t) = x(t) + phi(t), dx = -a x dt + sigma dW, x(0) = 0
+	// phi is chosen to fit the forward curve f exactly:
+	//	phi(t) = f(t) + sigma^2/(2 a^2) (1 - exp(-a t))^2
+	// Simulated arrays of k dates by np paths are stored date major so the
+	// innermost loops run over contiguous paths.
+	template<class T = double>
+	class hull_white {
+		forward_curve<T> f_; // not owned
+		T a_, sigma_;
+	public:
+		hull_white(const forward_curve<T>& f, T a, T sigma)
+			: f_(f), a_(a), sigma_(sigma)
+		{
+			ensure (a > 0);
+			ensure (sigma >= 0);
+		}
+
+		T B(T s, T t) const
+		{
+			return (1 - exp(-a_*(t - s)))/a_;
+		}
+		// log of A(s, t) where P(s, t) = A(s, t) exp(-B(s, t) x(s))
+		T logA(T s, T t) const
+		{
+			T b = B(s, t);
+			T e = exp(-a_*s);
+
+			return f_.integral(s) - f_.integral(t)
+				- sigma_*sigma_/(4*a_)*(1 - e*e)*b*b
+				- sigma_*sigma_/(2*a_*a_)*(1 - e)*(1 - e)*b;
+		}
+		// price at s of zero coupon bond maturing at t given x(s)
+		T zero(T s, T t, T x) const
+		{
+			return exp(logA(s, t) - B(s, t)*x);
+		}
+		// stochastic discount exp(-int_0^s r(u) du) given y = int_0^s x(u) du
+		T numeraire(T s, T y) const
+		{
+			T e = exp(-a_*s);
+			T Iphi = f_.integral(s) + sigma_*sigma_/(2*a_*a_)*(s - 2*(1 - e)/a_ + (1 - e*e)/(2*a_));
+
+			return exp(-Iphi - y);
+		}
+
+		// Exact joint simulation of x and y = int x on dates s[0] < ... < s[k-1]
+		// for paths [p0, p1) of np. Path p at date i uses counter p*k + i.
+		void simulate(size_t k, const T* s, size_t np, T* x, T* y, uint64_t seed, size_t p0, size_t p1) const
+		{
+			T s0(0);
+			for (size_t i = 0; i < k; ++i) {
+				T dt = s[i] - s0;
+				ensure (dt >= 0);
+				T e = exp(-a_*dt);
+				T b = (1 - e)/a_;
+				T vx = sigma_*sigma_*(1 - e*e)/(2*a_);
+				T vy = sigma_*sigma_/(a_*a_)*(dt - 2*b + (1 - e*e)/(2*a_));
+				T cxy = sigma_*sigma_*b*b/2;
+				T sx = sqrt(vx);
+				T rho = sx > 0 ? cxy/sx : 0;
+				T sy = vy > rho*rho ? sqrt(vy - rho*rho) : 0;
+
+				T* xi = x + i*np;
+				T* yi = y + i*np;
+				const T* x0 = i ? xi - np : 0;
+				const T* y0 = i ? yi - np : 0;
+				for (size_t p = p0; p < p1; ++p) {
+					T z1 = rng::normal<T>(seed, 2*(p*k + i));
+					T z2 = rng::normal<T>(seed, 2*(p*k + i) + 1);
+					T xp = i ? x0[p] : 0;
+					T yp = i ? y0[p] : 0;
+					xi[p] = xp*e + sx*z1;
+					yi[p] = yp + xp*b + rho*z1 + sy*z2;
+				}
+				s0 = s[i];
+			}
+		}
+		void simulate(size_t k, const T* s, size_t np, T* x, T* y, uint64_t seed, size_t threads = std::thread::hardware_concurrency()) const
+		{
+			parallel::for_range(np, [=](size_t p0, size_t p1) { simulate(k, s, np, x, y, seed, p0, p1); }, threads);
+		}
+
+		// Pathwise value v at each date of the cash flows strictly after that date.
+		// Bond coefficients are computed once per date and flow, not per path.
+		void value(const fixed_income::instrument<T>& i, size_t k, const T* s, size_t np, const T* x, T* v, size_t p0, size_t p1) const
+		{
+			for (size_t d = 0; d < k; ++d) {
+				const T* xd = x + d*np;
+				T* vd = v + d*np;
+
+				for (size_t p = p0; p < p1; ++p)
+					vd[p] = 0;
+				for (size_t j = 0; j < i.n; ++j) {
+					if (i.t[j] <= s[d])
+						continue;
+					T cA = i.c[j]*exp(logA(s[d], i.t[j]));
+					T b = B(s[d], i.t[j]);
+					for (size_t p = p0; p < p1; ++p)
+						vd[p] += cA*exp(-b*xd[p]);
+				}
+			}
+		}
+		void value(const fixed_income::instrument<T>& i, size_t k, const T* s, size_t np, const T* x, T* v, size_t threads = std::thread::hardware_concurrency()) const
+		{
+			parallel::for_range(np, [&i,k,s,np,x,v,this](size_t p0, size_t p1) { value(i, k, s, np, x, v, p0, p1); }, threads);
+		}
+
+		// discounted expected positive exposure E[D(s) max(v(s), 0)] at each date
+		void exposure(size_t k, const T* s, size_t np, const T* y, const T* v, T* epe) const
+		{
+			for (size_t d = 0; d < k; ++d) {
+				const T* yd = y + d*np;
+				const T* vd = v + d*np;
+				T e(0);
+
+				for (size_t p = 0; p < np; ++p)
+					e += numeraire(s[d], yd[p])*(vd[p] > 0 ? vd[p] : 0);
+				epe[d] = e/np;
+			}
+		}
+	};
+
+} // namespace pwflat
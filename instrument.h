@@ -68,7 +68,7 @@ namespace fixed_income {
 		}
 		const T& time(size_t i) const
 		{
-			ensure (i < size());
+			ensure_debug (i < size());
 			IT ti(tb_);
 
 			std::advance(ti, i);
@@ -77,7 +77,7 @@ namespace fixed_income {
 		}
 		T& time(size_t i)
 		{
-			ensure (i < size());
+			ensure_debug (i < size());
 			IT ti(tb_);
 
 			std::advance(ti, i);
@@ -92,7 +92,7 @@ namespace fixed_income {
 		}
 		const F& flow(size_t i) const
 		{
-			ensure (i < size());
+			ensure_debug (i < size());
 			IF fi(cb_);
 
 			std::advance(fi, i);
@@ -101,7 +101,7 @@ namespace fixed_income {
 		}
 		F& flow(size_t i)
 		{
-			ensure (i < size());
+			ensure_debug (i < size());
 			IF fi(cb_);
 
 			std::advance(fi, i);
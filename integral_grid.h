@@ -0,0 +1,375 @@
+// integral_grid.h - int_0^u f for many query times with gather and fused multiply-add
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <algorithm>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "ensure.h"
+#include "cpu_dispatch.h"
+
+namespace pwflat {
+
+	// Bucket records of a curve for the kernels. Query u is in bucket b = trunc(u ih) clamped to [0, bmax]
+	// and each bucket holds at most one knot. Record r[4 b, ..., 4 b + 3] = {tk, Ik, f0, f1} has
+	// int_0^u f = Ik + (u < tk ? f0 : f1) (u - tk) for every u in the bucket, where tk is the knot in
+	// the bucket, or the last knot before it with f0 = f1. Records are contiguous, so vector kernels
+	// load and transpose them instead of gathering.
+	template<class T = double>
+	struct integral_grid_view {
+		const T* r;
+		T ih, bmax;
+	};
+
+	template<class T>
+	inline void integral_grid_scalar(const integral_grid_view<T>& g, size_t W, const T* u, T* I) noexcept
+	{
+		for (size_t w = 0; w < W; ++w) {
+			T x = u[w]*g.ih;
+			x = x > 0 ? x : 0; // NaN goes to bucket 0
+			x = x < g.bmax ? x : g.bmax;
+			const T* r = g.r + 4*static_cast<int>(x);
+			T d = u[w] - r[0];
+			I[w] = r[1] + (d < 0 ? r[2] : r[3])*d;
+		}
+	}
+
+#if defined(PWFLAT_X86)
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic push // gcc 12 warns about the undefined source operand of avx512 intrinsics
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+	// bucket indices of 4 doubles
+	PWFLAT_TARGET("avx2,fma")
+	inline __m128i integral_grid_bucket(__m256d x, __m256d ih, __m256d bmax)
+	{
+		return _mm256_cvttpd_epi32(_mm256_min_pd(_mm256_max_pd(_mm256_mul_pd(x, ih), _mm256_setzero_pd()), bmax));
+	}
+	// Ik + (d < 0 ? f0 : f1) d, d = x - tk, from the records at r + 4 b[0], ..., r + 4 b[3]
+	PWFLAT_TARGET("avx2,fma")
+	inline __m256d integral_grid_eval(const double* r, const int* b, __m256d x)
+	{
+		__m256d r0 = _mm256_loadu_pd(r + 4*b[0]), r1 = _mm256_loadu_pd(r + 4*b[1]);
+		__m256d r2 = _mm256_loadu_pd(r + 4*b[2]), r3 = _mm256_loadu_pd(r + 4*b[3]);
+		__m256d lo01 = _mm256_unpacklo_pd(r0, r1), hi01 = _mm256_unpackhi_pd(r0, r1);
+		__m256d lo23 = _mm256_unpacklo_pd(r2, r3), hi23 = _mm256_unpackhi_pd(r2, r3);
+		__m256d tk = _mm256_permute2f128_pd(lo01, lo23, 0x20);
+		__m256d Ik = _mm256_permute2f128_pd(hi01, hi23, 0x20);
+		__m256d f0 = _mm256_permute2f128_pd(lo01, lo23, 0x31);
+		__m256d f1 = _mm256_permute2f128_pd(hi01, hi23, 0x31);
+		__m256d d = _mm256_sub_pd(x, tk);
+
+		return _mm256_fmadd_pd(_mm256_blendv_pd(f1, f0, _mm256_cmp_pd(d, _mm256_setzero_pd(), _CMP_LT_OQ)), d, Ik);
+	}
+	// same for 4 floats
+	PWFLAT_TARGET("avx2,fma")
+	inline __m128 integral_grid_eval(const float* r, const int* b, __m128 x)
+	{
+		__m128 tk = _mm_loadu_ps(r + 4*b[0]), Ik = _mm_loadu_ps(r + 4*b[1]);
+		__m128 f0 = _mm_loadu_ps(r + 4*b[2]), f1 = _mm_loadu_ps(r + 4*b[3]);
+		_MM_TRANSPOSE4_PS(tk, Ik, f0, f1);
+		__m128 d = _mm_sub_ps(x, tk);
+
+		return _mm_fmadd_ps(_mm_blendv_ps(f1, f0, _mm_cmplt_ps(d, _mm_setzero_ps())), d, Ik);
+	}
+
+	PWFLAT_TARGET("avx2,fma")
+	inline void integral_grid_avx2(const integral_grid_view<double>& g, size_t W, const double* u, double* I) noexcept
+	{
+		const __m256d ih = _mm256_set1_pd(g.ih), bmax = _mm256_set1_pd(g.bmax);
+		alignas(16) int b[4];
+		size_t w = 0;
+
+		for (; w + 4 <= W; w += 4) {
+			__m256d x = _mm256_loadu_pd(u + w);
+			_mm_store_si128(reinterpret_cast<__m128i*>(b), integral_grid_bucket(x, ih, bmax));
+			_mm256_storeu_pd(I + w, integral_grid_eval(g.r, b, x));
+		}
+
+		integral_grid_scalar(g, W - w, u + w, I + w);
+	}
+	PWFLAT_TARGET("avx2,fma")
+	inline void integral_grid_avx2(const integral_grid_view<float>& g, size_t W, const float* u, float* I) noexcept
+	{
+		const __m256 ih = _mm256_set1_ps(g.ih), bmax = _mm256_set1_ps(g.bmax), zero = _mm256_setzero_ps();
+		alignas(32) int b[8];
+		size_t w = 0;
+
+		for (; w + 8 <= W; w += 8) {
+			__m256 x = _mm256_loadu_ps(u + w);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(b),
+				_mm256_cvttps_epi32(_mm256_min_ps(_mm256_max_ps(_mm256_mul_ps(x, ih), zero), bmax)));
+			__m128 I0 = integral_grid_eval(g.r, b, _mm256_castps256_ps128(x));
+			__m128 I1 = integral_grid_eval(g.r, b + 4, _mm256_extractf128_ps(x, 1));
+			_mm256_storeu_ps(I + w, _mm256_insertf128_ps(_mm256_castps128_ps256(I0), I1, 1));
+		}
+
+		integral_grid_scalar(g, W - w, u + w, I + w);
+	}
+
+	PWFLAT_TARGET("avx512f,avx512vl")
+	inline void integral_grid_avx512(const integral_grid_view<double>& g, size_t W, const double* u, double* I) noexcept
+	{
+		const __m512d ih = _mm512_set1_pd(g.ih), bmax = _mm512_set1_pd(g.bmax), zero = _mm512_setzero_pd();
+		alignas(32) int b[8];
+		size_t w = 0;
+
+		for (; w + 8 <= W; w += 8) {
+			__m512d x = _mm512_loadu_pd(u + w);
+			_mm256_store_si256(reinterpret_cast<__m256i*>(b),
+				_mm512_cvttpd_epi32(_mm512_min_pd(_mm512_max_pd(_mm512_mul_pd(x, ih), zero), bmax)));
+			__m256d I0 = integral_grid_eval(g.r, b, _mm512_castpd512_pd256(x));
+			__m256d I1 = integral_grid_eval(g.r, b + 4, _mm512_extractf64x4_pd(x, 1));
+			_mm512_storeu_pd(I + w, _mm512_insertf64x4(_mm512_castpd256_pd512(I0), I1, 1));
+		}
+
+		integral_grid_scalar(g, W - w, u + w, I + w);
+	}
+	PWFLAT_TARGET("avx512f,avx512vl")
+	inline void integral_grid_avx512(const integral_grid_view<float>& g, size_t W, const float* u, float* I) noexcept
+	{
+		const __m512 ih = _mm512_set1_ps(g.ih), bmax = _mm512_set1_ps(g.bmax), zero = _mm512_setzero_ps();
+		alignas(64) int b[16];
+		size_t w = 0;
+
+		for (; w + 16 <= W; w += 16) {
+			__m512 x = _mm512_loadu_ps(u + w);
+			_mm512_store_si512(b, _mm512_cvttps_epi32(_mm512_min_ps(_mm512_max_ps(_mm512_mul_ps(x, ih), zero), bmax)));
+			__m512 Iw = _mm512_castps128_ps512(integral_grid_eval(g.r, b, _mm512_castps512_ps128(x)));
+			Iw = _mm512_insertf32x4(Iw, integral_grid_eval(g.r, b + 4, _mm512_extractf32x4_ps(x, 1)), 1);
+			Iw = _mm512_insertf32x4(Iw, integral_grid_eval(g.r, b + 8, _mm512_extractf32x4_ps(x, 2)), 2);
+			Iw = _mm512_insertf32x4(Iw, integral_grid_eval(g.r, b + 12, _mm512_extractf32x4_ps(x, 3)), 3);
+			_mm512_storeu_ps(I + w, Iw);
+		}
+
+		integral_grid_scalar(g, W - w, u + w, I + w);
+	}
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+#endif // PWFLAT_X86
+
+	// kernel for a level, the scalar reference if T has no vector kernel
+	template<class T>
+	struct integral_grid_kernel {
+		typedef void (*type)(const integral_grid_view<T>&, size_t, const T*, T*);
+		static type select(simd_level)
+		{
+			return integral_grid_scalar<T>;
+		}
+	};
+#if defined(PWFLAT_X86)
+	template<class T>
+	struct integral_grid_kernel_x86 {
+		typedef void (*type)(const integral_grid_view<T>&, size_t, const T*, T*);
+		static type select(simd_level level)
+		{
+			switch (level) {
+			case SIMD_AVX512:
+				return integral_grid_avx512;
+			case SIMD_AVX2:
+				return integral_grid_avx2;
+			default:
+				return integral_grid_scalar<T>;
+			}
+		}
+	};
+	template<>
+	struct integral_grid_kernel<double> : public integral_grid_kernel_x86<double> { };
+	template<>
+	struct integral_grid_kernel<float> : public integral_grid_kernel_x86<float> { };
+#endif
+
+	// Batch int_0^u f for a piecewise flat curve. Kernels need a grid with at most one
+	// knot per bucket, so the bucket width is below the smallest knot spacing. If that takes more
+	// than max_buckets buckets the grid is not built and queries use a binary search.
+	template<class T = double>
+	class integral_grid {
+		size_t n_;
+		std::vector<int> k_;    // knots in earlier buckets, only while building
+		std::vector<T> t_, t0_, I0_, f_;
+		std::vector<T> r_;      // bucket records
+		size_t a_;              // r_[a_] is aligned to the record size
+		T ih_, bmax_;
+		simd_level level_;
+		typename integral_grid_kernel<T>::type kernel_;
+
+		// bucket knots with width 1/ih_, false if a bucket has two knots
+		bool build(size_t max_buckets)
+		{
+			int b0 = -1;
+
+			k_.clear();
+			for (size_t i = 0; i < n_; ++i) {
+				T x = t_[i]*ih_;
+				if (!(x < static_cast<T>(max_buckets - 1)))
+					return false;
+				int b = static_cast<int>(x);
+				if (b <= b0)
+					return false;
+				k_.resize(b + 1, static_cast<int>(i));
+				b0 = b;
+			}
+			k_.resize(b0 + 2, static_cast<int>(n_));
+			bmax_ = static_cast<T>(k_.size() - 1);
+
+			return true;
+		}
+		// records from the bucketed knots
+		void records(void)
+		{
+			size_t B = k_.size(), R = 4*sizeof(T);
+
+			r_.assign(4*B + 4, 0);
+			a_ = (R - reinterpret_cast<uintptr_t>(&r_[0]) % R) % R/sizeof(T);
+			for (size_t b = 0; b < B; ++b) {
+				size_t k = k_[b];
+				T* r = &r_[a_ + 4*b];
+				if (b + 1 < B && static_cast<size_t>(k_[b + 1]) == k + 1) { // t[k] is in bucket b
+					r[0] = t_[k];
+					r[1] = I0_[k + 1];
+					r[2] = f_[k];
+					r[3] = f_[k + 1];
+				}
+				else {
+					r[0] = t0_[k];
+					r[1] = I0_[k];
+					r[2] = r[3] = f_[k];
+				}
+			}
+			std::vector<int>().swap(k_);
+		}
+	public:
+		integral_grid(size_t n, const T* t, const T* f, T _f = 0,
+			simd_level level = simd_selected(), size_t max_buckets = 1 << 22)
+			: n_(n), t_(n + 1), t0_(n + 1), I0_(n + 1), f_(n + 1), a_(0), ih_(0), bmax_(0),
+			  level_(level),
+			  kernel_(integral_grid_kernel<T>::select(level_))
+		{
+			ensure (n < static_cast<size_t>(INT_MAX));
+
+			T I(0), s(0), dt = std::numeric_limits<T>::max();
+			for (size_t i = 0; i <= n; ++i) {
+				t0_[i] = s;
+				I0_[i] = I;
+				if (i < n) {
+					ensure (t[i] > s || (i == 0 && t[i] >= 0));
+					if (t[i] > s)
+						dt = std::min(dt, t[i] - s);
+					t_[i] = t[i];
+					f_[i] = f[i];
+					I += f[i]*(t[i] - s); // same arithmetic as integral()
+					s = t[i];
+				}
+			}
+			t_[n] = std::numeric_limits<T>::quiet_NaN();
+			f_[n] = _f;
+
+			if (n == 0 || dt == std::numeric_limits<T>::max()) {
+				ih_ = 1;
+				k_.assign(1, 0);
+				if (n)
+					k_.push_back(1);
+				bmax_ = static_cast<T>(k_.size() - 1);
+			}
+			else {
+				for (ih_ = 1/dt; !build(max_buckets); ih_ *= 2) {
+					if (t_[n - 1]*ih_ >= max_buckets) { // too fine
+						k_.clear();
+						break;
+					}
+				}
+			}
+			if (!k_.empty())
+				records();
+		}
+
+		size_t size(void) const
+		{
+			return n_;
+		}
+		simd_level level(void) const
+		{
+			return level_;
+		}
+		// false if queries fall back to binary search
+		bool grid(void) const
+		{
+			return !r_.empty();
+		}
+		integral_grid_view<T> view(void) const
+		{
+			integral_grid_view<T> g = {r_.empty() ? 0 : &r_[a_], ih_, bmax_};
+
+			return g;
+		}
+
+		T integral(T u) const noexcept
+		{
+			T I;
+			integral(1, &u, &I);
+
+			return I;
+		}
+		// I[w] = int_0^u[w] f for w < W
+		void integral(size_t W, const T* u, T* I) const noexcept
+		{
+			if (!grid()) {
+				for (size_t w = 0; w < W; ++w) {
+					size_t k = std::upper_bound(t_.begin(), t_.begin() + n_, u[w]) - t_.begin();
+					I[w] = I0_[k] + f_[k]*(u[w] - t0_[k]);
+				}
+			}
+			else {
+				kernel_(view(), W, u, I);
+			}
+		}
+		// D[w] = exp(-int_0^u[w] f)
+		void discount(size_t W, const T* u, T* D) const noexcept
+		{
+			integral(W, u, D);
+			for (size_t w = 0; w < W; ++w)
+				D[w] = exp(-D[w]);
+		}
+		// sum c[j] D(u[j]) in blocks on the stack
+		T present_value(size_t m, const T* u, const T* c) const noexcept
+		{
+			T D[256], pv(0);
+
+			for (size_t j = 0; j < m; j += 256) {
+				size_t W = std::min<size_t>(256, m - j);
+				discount(W, u + j, D);
+				for (size_t w = 0; w < W; ++w)
+					pv += c[j + w]*D[w];
+			}
+
+			return pv;
+		}
+	};
+
+	// Level of the fastest integral_grid kernel for T on this cpu, measured on a 30 year
+	// quarterly curve when first called. Takes a few milliseconds and may differ between runs.
+	template<class T>
+	inline simd_level integral_grid_fastest(void)
+	{
+		static simd_level level = []() {
+			std::vector<T> t(120), f(120), u(4096), I(4096);
+			for (size_t i = 0; i < t.size(); ++i) {
+				t[i] = static_cast<T>((i + 1)/4.);
+				f[i] = static_cast<T>(0.02 + 0.0001*i);
+			}
+			for (size_t w = 0; w < u.size(); ++w)
+				u[w] = static_cast<T>(((w*2654435761u) % 3000)/100.); // scattered in [0, 30)
+			integral_grid<T> g(t.size(), &t[0], &f[0], 0, SIMD_SCALAR);
+
+			return simd_fastest([&](simd_level l) {
+				integral_grid_kernel<T>::select(l)(g.view(), u.size(), &u[0], &I[0]);
+			});
+		}();
+
+		return level;
+	}
+
+} // namespace pwflat
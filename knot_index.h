@@ -0,0 +1,122 @@
+// knot_index.h - branch free knot search for large piecewise flat curves
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <cstddef>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#include "ensure.h"
+
+namespace pwflat {
+
+	// count trailing zeros of a nonzero x
+	inline unsigned ctz(size_t x)
+	{
+#if defined(_MSC_VER)
+		unsigned long i;
+#if defined(_WIN64)
+		_BitScanForward64(&i, x);
+#else
+		_BitScanForward(&i, x);
+#endif
+		return i;
+#else
+		return static_cast<unsigned>(__builtin_ctzll(x));
+#endif
+	}
+
+	// Knot times in Eytzinger (breadth first) layout with integrals at the knots.
+	// The search touches one cache line per level and the loop has no data dependent branch.
+	// Built once per curve and used by forward_curve when set.
+	template<class T = double>
+	class knot_index {
+		size_t n_;
+		std::vector<T> b_;      // b_[k], k = 1..n, is the knot at sorted index i_[k]
+		std::vector<size_t> i_;
+		std::vector<T> t_;
+		std::vector<T> f_;
+		std::vector<T> I_;      // I_[i] = int_0^t[i] f(s) ds
+
+		size_t build(size_t i, size_t k)
+		{
+			if (k <= n_) {
+				i = build(i, 2*k);
+				b_[k] = t_[i];
+				i_[k] = i++;
+				i = build(i, 2*k + 1);
+			}
+
+			return i;
+		}
+		// first i with t[i] > u if upper, else first i with t[i] >= u, n if none
+		template<bool upper>
+		size_t search(T u) const noexcept
+		{
+			const T* b = &b_[0];
+			size_t k = 1;
+
+			while (k <= n_) {
+#if defined(__GNUC__)
+				__builtin_prefetch(b + 16*k);
+#endif
+				k = 2*k + (upper ? !(u < b[k]) : b[k] < u);
+			}
+			k >>= ctz(~k) + 1;
+
+			return k ? i_[k] : n_;
+		}
+	public:
+		knot_index(size_t n, const T* t, const T* f)
+			: n_(n), b_(n + 1), i_(n + 1), t_(t, t + n), f_(f, f + n), I_(n)
+		{
+			T I(0), t0(0);
+			for (size_t i = 0; i < n; ++i) {
+				ensure (t[i] > t0 || (i == 0 && t[i] >= 0));
+				I += f[i]*(t[i] - t0); // same arithmetic as integral()
+				I_[i] = I;
+				t0 = t[i];
+			}
+
+			build(0, 1);
+		}
+
+		size_t size(void) const
+		{
+			return n_;
+		}
+		// built from these knots and forwards
+		bool matches(size_t n, const T* t, const T* f) const
+		{
+			if (n != n_)
+				return false;
+			for (size_t i = 0; i < n; ++i)
+				if (t[i] != t_[i] || f[i] != f_[i])
+					return false;
+
+			return true;
+		}
+		size_t lower_bound(T u) const noexcept
+		{
+			return search<false>(u);
+		}
+		size_t upper_bound(T u) const noexcept
+		{
+			return search<true>(u);
+		}
+
+		T value(T u, T _f = 0) const noexcept
+		{
+			size_t i = lower_bound(u);
+
+			return i != n_ ? f_[i] : _f;
+		}
+		T integral(T u, T _f = 0) const noexcept
+		{
+			size_t i = upper_bound(u);
+
+			return i ? I_[i-1] + (i != n_ ? f_[i] : _f)*(u - t_[i-1]) : (n_ ? f_[0] : _f)*u;
+		}
+	};
+
+} // namespace pwflat
@@ -0,0 +1,192 @@
+// monotone_convex.h - Hagan-West monotone convex forward curve
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+// See papers/Hagan_West_curves_AMF.pdf
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "ensure.h"
+#include "forward_curve.h"
+#include "pwflat.h"
+
+namespace monotone_convex {
+
+	// Continuous forward with the same integral as the discrete forwards fd over each
+	// period (t[i-1], t[i]], so discount factors at the knots agree with the piecewise
+	// flat curve it is built from. Extrapolates with _f past t[n-1] like pwflat.
+	template<class T = double>
+	class forward_curve : public fixed_income::forward_curve<T,T> {
+		std::vector<T> t_;  // t_[0] = 0, t_[i] = t[i-1]
+		std::vector<T> fd_; // discrete forward on (t_[i], t_[i+1]]
+		std::vector<T> f_;  // instantaneous forward at t_[i]
+		std::vector<T> I_;  // I_[i] = int_0^t_[i] f(s) ds
+		T _f;
+
+		// g(x) = f - fd on period i as a function of x = (u - t_[i])/(t_[i+1] - t_[i])
+		// and its integral G(x) = int_0^x g, G(1) = 0
+		void g(size_t i, T x, T* gx, T* Gx) const
+		{
+			T g0 = f_[i] - fd_[i];
+			T g1 = f_[i+1] - fd_[i];
+
+			if (g0 == 0 && g1 == 0) {
+				*gx = 0;
+				*Gx = 0;
+			}
+			else if ((g0 < 0 && -g0/2 <= g1 && g1 <= -2*g0) || (g0 > 0 && -g0/2 >= g1 && g1 >= -2*g0)) {
+				// (i) quadratic
+				*gx = g0*(1 - 4*x + 3*x*x) + g1*(-2*x + 3*x*x);
+				*Gx = g0*(x - 2*x*x + x*x*x) + g1*(-x*x + x*x*x);
+			}
+			else if ((g0 < 0 && g1 > -2*g0) || (g0 > 0 && g1 < -2*g0)) {
+				// (ii) flat then quadratic
+				T eta = (g1 + 2*g0)/(g1 - g0);
+				*gx = g0;
+				*Gx = g0*x;
+				if (x > eta) {
+					T y = (x - eta)/(1 - eta);
+					*gx += (g1 - g0)*y*y;
+					*Gx += (g1 - g0)*y*y*(x - eta)/3;
+				}
+			}
+			else if ((g0 > 0 && 0 > g1 && g1 > -g0/2) || (g0 < 0 && 0 < g1 && g1 < -g0/2)) {
+				// (iii) quadratic then flat
+				T eta = 3*g1/(g1 - g0);
+				T x_ = x < eta ? x : eta;
+				T y = (eta - x_)/eta;
+				*gx = g1 + (g0 - g1)*y*y;
+				*Gx = g1*x + (g0 - g1)*(eta - y*y*(eta - x_))/3;
+			}
+			else {
+				// (iv) g0 and g1 have the same sign
+				T eta = g1/(g1 + g0);
+				T A = -g0*g1/(g0 + g1);
+				*gx = A;
+				*Gx = A*x;
+				if (eta > 0) {
+					T x_ = x < eta ? x : eta;
+					T y = (eta - x_)/eta;
+					if (x < eta)
+						*gx += (g0 - A)*y*y;
+					*Gx += (g0 - A)*(eta - y*y*(eta - x_))/3;
+				}
+				if (x > eta) {
+					T y = (x - eta)/(1 - eta);
+					*gx += (g1 - A)*y*y;
+					*Gx += (g1 - A)*y*y*(x - eta)/3;
+				}
+			}
+		}
+		// period containing u, t_[i] < u <= t_[i+1]
+		size_t period(T u) const
+		{
+			size_t i = std::lower_bound(t_.begin() + 1, t_.end(), u) - t_.begin();
+
+			return i - 1;
+		}
+	public:
+		forward_curve(size_t n = 0, const T* t = 0, const T* fd = 0, T _f_ = 0)
+			: _f(_f_)
+		{
+			set(n, t, fd);
+		}
+		forward_curve(const pwflat::forward_curve<T>& f)
+			: _f(f._f)
+		{
+			set(f.n, f.t, f.f);
+		}
+		virtual ~forward_curve()
+		{ }
+
+		void set(size_t n, const T* t, const T* fd)
+		{
+			t_.assign(1, 0);
+			t_.insert(t_.end(), t, t + n);
+			fd_.assign(fd, fd + n);
+			f_.resize(n + 1);
+			I_.resize(n + 1);
+
+			if (n == 0)
+				return;
+
+			// interior knots weight neighbouring discrete forwards by the opposite period length
+			for (size_t i = 1; i < n; ++i) {
+				T h0 = t_[i] - t_[i-1], h1 = t_[i+1] - t_[i];
+				f_[i] = (h0*fd_[i] + h1*fd_[i-1])/(h0 + h1);
+			}
+			if (n == 1) {
+				f_[0] = f_[1] = fd_[0];
+			}
+			else {
+				f_[0] = fd_[0] - (f_[1] - fd_[0])/2;
+				f_[n] = fd_[n-1] - (f_[n-1] - fd_[n-1])/2;
+			}
+
+			I_[0] = 0;
+			for (size_t i = 0; i < n; ++i) {
+				ensure (t_[i+1] > t_[i]);
+				I_[i+1] = I_[i] + fd_[i]*(t_[i+1] - t_[i]);
+			}
+		}
+
+		size_t size(void) const
+		{
+			return fd_.size();
+		}
+
+		T value(const T& u) const
+		{
+			if (size() == 0 || u > t_.back())
+				return _f;
+			if (u <= 0)
+				return f_[0];
+
+			size_t i = period(u);
+			T gx, Gx;
+			g(i, (u - t_[i])/(t_[i+1] - t_[i]), &gx, &Gx);
+
+			return fd_[i] + gx;
+		}
+		T operator()(T u) const
+		{
+			return value(u);
+		}
+		T integral(const T& u) const
+		{
+			if (size() == 0)
+				return _f*u;
+			if (u > t_.back())
+				return I_.back() + _f*(u - t_.back());
+			if (u <= 0)
+				return f_[0]*u;
+
+			size_t i = period(u);
+			T h = t_[i+1] - t_[i];
+			T gx, Gx;
+			g(i, (u - t_[i])/h, &gx, &Gx);
+
+			return I_[i] + fd_[i]*(u - t_[i]) + h*Gx;
+		}
+		T discount(T u) const
+		{
+			return exp(-integral(u));
+		}
+	};
+
+	template<class T>
+	inline T value(T u, const forward_curve<T>& f)
+	{
+		return f.value(u);
+	}
+	template<class T>
+	inline T integral(T u, const forward_curve<T>& f)
+	{
+		return f.integral(u);
+	}
+	template<class T>
+	inline T discount(T u, const forward_curve<T>& f)
+	{
+		return f.discount(u);
+	}
+
+} // namespace monotone_convex
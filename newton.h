@@ -1,6 +1,7 @@
 // newton.h - self containted 1d root finding using the Newton method
 // Copyright (c) 2013 KALX, LLC. All rights reserved.
 #pragma once
+#include <cmath>
 #include <limits>
 
 namespace root1d {
@@ -15,12 +16,85 @@ namespace root1d {
 			T x_ = x - fx/dfx;
 			if (x_ == x)
 				break;
+			T fx_ = f(x_);
+			// tiny step that does not reduce |f| means f is at rounding noise
+			if (fabs(fx_) >= fabs(fx) && fabs(x_ - x) <= sqrt(std::numeric_limits<T>::epsilon())*(1 + fabs(x)))
+				break;
 			x = x_;
-			fx = f(x);
+			fx = fx_;
 			dfx = df(x);
 		} 
 
 		return (iter && 1 + dfx != 1) ? x : std::numeric_limits<T>::quiet_NaN();
 	}
 
+	// same as newton with fdf(x) returning the pair f(x), df(x) from one evaluation
+	// and the number of steps taken added to *steps if not null
+	template<class T, class FdF>
+	inline T newton_fdf(T x, const FdF& fdf, size_t iter = -1, size_t* steps = 0)
+	{
+		auto y = fdf(x);
+		T fx = y.first;
+		T dfx = y.second;
+
+		while (iter-- && 1 + fx != 1 && 1 + dfx != 1) {
+			T x_ = x - fx/dfx;
+			if (x_ == x)
+				break;
+			if (steps)
+				++*steps;
+			auto y_ = fdf(x_);
+			// tiny step that does not reduce |f| means f is at rounding noise
+			if (fabs(y_.first) >= fabs(fx) && fabs(x_ - x) <= sqrt(std::numeric_limits<T>::epsilon())*(1 + fabs(x)))
+				break;
+			x = x_;
+			fx = y_.first;
+			dfx = y_.second;
+		} 
+
+		return (iter && 1 + dfx != 1) ? x : std::numeric_limits<T>::quiet_NaN();
+	}
+
+	// Newton safeguarded by the bracket [lo, hi] where f(lo) and f(hi) have opposite signs.
+	// Steps leaving the bracket are replaced by bisection so it always converges.
+	// Returns NaN if f(lo) and f(hi) do not bracket a root.
+	template<class T, class FdF>
+	inline T newton_bracket(T x, const FdF& fdf, T lo, T hi, size_t iter = 200, size_t* steps = 0)
+	{
+		T flo = fdf(lo).first;
+		T fhi = fdf(hi).first;
+
+		if (flo == 0)
+			return lo;
+		if (fhi == 0)
+			return hi;
+		if ((flo < 0) == (fhi < 0))
+			return std::numeric_limits<T>::quiet_NaN();
+		if (!(lo < x && x < hi))
+			x = lo + (hi - lo)/2;
+
+		while (iter--) {
+			auto y = fdf(x);
+			if (y.first == 0)
+				break;
+			if ((y.first < 0) == (flo < 0))
+				lo = x;
+			else
+				hi = x;
+
+			T x_ = x - y.first/y.second;
+			if (!(lo < x_ && x_ < hi)) // also catches df = 0
+				x_ = lo + (hi - lo)/2;
+			if (steps)
+				++*steps;
+			if (x_ == x || fabs(x_ - x) <= std::numeric_limits<T>::epsilon()*fabs(x)) {
+				x = x_;
+				break;
+			}
+			x = x_;
+		}
+
+		return x;
+	}
+
 } // namespace root1d
@@ -0,0 +1,52 @@
+// parallel.h - split a range of independent work over threads
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+	// call f(b, e) on consecutive chunks [b, e) covering [0, n) using at most threads threads
+	template<class F>
+	inline void for_range(size_t n, const F& f, size_t threads = std::thread::hardware_concurrency())
+	{
+		if (threads == 0)
+			threads = 1;
+		if (threads > n)
+			threads = n;
+		if (threads <= 1) {
+			if (n)
+				f(static_cast<size_t>(0), n);
+
+			return;
+		}
+
+		std::vector<std::exception_ptr> ex(threads);
+		std::vector<std::thread> pool;
+		for (size_t k = 1; k < threads; ++k) {
+			pool.push_back(std::thread([&f,&ex,k,n,threads] {
+				try {
+					f(k*n/threads, (k + 1)*n/threads);
+				}
+				catch (...) {
+					ex[k] = std::current_exception();
+				}
+			}));
+		}
+		try {
+			f(static_cast<size_t>(0), n/threads);
+		}
+		catch (...) {
+			ex[0] = std::current_exception();
+		}
+		for (auto& t : pool)
+			t.join();
+
+		for (auto& e : ex) {
+			if (e)
+				std::rethrow_exception(e);
+		}
+	}
+
+} // namespace parallel
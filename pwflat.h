@@ -2,12 +2,39 @@
 // Copyright (c) 2013 KALX, LLC. All rights reserved.
 #pragma once
 #include <algorithm>
+#include <cmath>
 #include <functional>
 #include <limits>
 #include "fixed_income.h"
+#include "knot_index.h"
 
 namespace pwflat {
 
+	// note value(t[i]) = f[i]
+	template<class T>
+	inline T value(T u, size_t n, const T* t, const T* f, T _f = 0) noexcept
+	{
+		const T* ti = std::lower_bound(t, t + n, u); // left continuous
+
+		return ti != t + n ? f[ti - t] : _f;
+	}
+
+	// int_0^u f(s) ds
+	template<class T>
+	inline T integral(T u, size_t n, const T* t, const T* f, T _f = 0) noexcept
+	{
+		T I(0), t0(0);
+
+		while (n-- && *t <= u) {
+			I += *f++ * (*t - t0);
+			t0 = *t++;
+		}
+
+		I += (n != static_cast<size_t>(-1) ? *f : _f)*(u - t0);
+
+		return I;
+	}
+
 	// f(u) = f[i], t[i-1] < u <= t[i]; f(u) = _f, u > t[n-1]
 	template<class T = double>
 	struct forward_curve {
@@ -15,11 +42,12 @@ namespace pwflat {
 		const T* t;
 		const T* f;
 		T _f; // extrapolate
+		const knot_index<T>* index; // optional, not owned, built from n, t, f
 		forward_curve(T f)
-			: n(0), t(0), f(0), _f(f)
+			: n(0), t(0), f(0), _f(f), index(0)
 		{ }
 		forward_curve(size_t n_ = 0, const T* t_ = 0, const T* f_ = 0, T _f_ = 0)
-			: n(n_), t(t_), f(f_), _f(_f_)
+			: n(n_), t(t_), f(f_), _f(_f_), index(0)
 		{ }
 		virtual ~forward_curve()
 		{ }
@@ -29,65 +57,97 @@ namespace pwflat {
 			t = t_;
 			f = f_;
 			_f = _f_;
+			index = 0;
+		}
+		// use i for knot search, it must be built from n, t, f and outlive the curve
+		forward_curve& set_index(const knot_index<T>* i)
+		{
+			ensure (i == 0 || i->size() == n);
+			ensure_debug (i == 0 || i->matches(n, t, f));
+
+			index = i;
+
+			return *this;
 		}
-		T operator()(T u) const
+		T operator()(T u) const noexcept
 		{
-			return pwflat::value(u, n, t, f, _f);
+			return value(u);
 		}
-		T value(T u) const
+		T value(T u) const noexcept
 		{
-			return pwflat::value(u, n, t, f, _f);
+			return index ? index->value(u, _f) : pwflat::value(u, n, t, f, _f);
 		}
-		T integral(T u) const
+		T integral(T u) const noexcept
 		{
-			return pwflat::integral(u, n, t, f, _f);
+			return index ? index->integral(u, _f) : pwflat::integral(u, n, t, f, _f);
 		}
 	};
 
-	// note value(t[i]) = f[i]
 	template<class T>
-	inline T value(T u, size_t n, const T* t, const T* f, T _f = 0)
+	inline T value(T u, const forward_curve<T>& f)
 	{
-		const T* ti = std::lower_bound(t, t + n, u); // left continuous
-
-		return ti != t + n ? f[ti - t] : _f;
+		return f.value(u);
 	}
+
 	template<class T>
-	inline T value(T u, const forward_curve<T>& f)
+	inline T integral(T u, const forward_curve<T>& f)
 	{
-		return value(u, f.n, f.t, f.f, f._f);
+		return f.integral(u);
 	}
 
-	// int_0^u f(s) ds
+	// int_0^u f(s) ds for nondecreasing u without rewalking the knots
 	template<class T>
-	inline T integral(T u, size_t n, const T* t, const T* f, T _f = 0)
-	{
-		T I(0), t0(0);
+	class integral_cursor {
+		size_t n;
+		const T* t;
+		const T* f;
+		T _f;
+		size_t i; // t[i-1] <= u < t[i]
+		T t0, I0; // I0 = int_0^t0 f(s) ds
+	public:
+		integral_cursor(size_t n_, const T* t_, const T* f_, T _f_ = 0) noexcept
+			: n(n_), t(t_), f(f_), _f(_f_), i(0), t0(0), I0(0)
+		{ }
+		integral_cursor(const forward_curve<T>& f_) noexcept
+			: n(f_.n), t(f_.t), f(f_.f), _f(f_._f), i(0), t0(0), I0(0)
+		{ }
+		// same arithmetic as integral() so results agree exactly
+		T operator()(T u) noexcept
+		{
+			if (u < t0) { // start over
+				i = 0;
+				t0 = 0;
+				I0 = 0;
+			}
+			while (i < n && t[i] <= u) {
+				I0 += f[i] * (t[i] - t0);
+				t0 = t[i];
+				++i;
+			}
 
-		while (n-- && *t <= u) {
-			I += *f++ * (*t - t0);
-			t0 = *t++;
+			return I0 + (i < n ? f[i] : _f)*(u - t0);
 		}
+	};
 
-		I += (n != -1 ? *f : _f)*(u - t0);
-
-		return I;
-	}
 	template<class T>
-	inline T integral(T u, const forward_curve<T>& f)
+	inline T discount(T u, size_t n, const T* t, const T* f, T _f = 0) noexcept
 	{
-		return f.integral(u);
+		return exp(-integral(u, n, t, f, _f));
 	}
-
 	template<class T>
-	inline T discount(T u, size_t n, const T* t, const T* f, T _f = 0)
+	inline T discount(T u, const forward_curve<T>& f)
 	{
-		return exp(-integral(u, n, t, f, _f));
+		return exp(-f.integral(u));
 	}
+
+	// survival S(u) = P(T > u) = exp(-int_0^u h(s) ds) for piecewise flat hazard rate h
+	template<class T = double>
+	using hazard_curve = forward_curve<T>;
+
 	template<class T>
-	inline T discount(T u, const forward_curve<T>& f)
+	inline T survival(T u, const hazard_curve<T>& h)
 	{
-		return discount(u, f.n, f.t, f.f, f._f);
+		return exp(-h.integral(u));
 	}
 
 	template<class T>
@@ -98,11 +158,11 @@ namespace pwflat {
 	template<class T>
 	inline T spot(T u, const forward_curve<T>& f)
 	{
-		return spot(u, f.n, f.t, f.f, f._f);
+		return 1 + u == 1 ? (f.n == 0 ? f._f : f.f[0]) : f.integral(u)/u;
 	}
 
 	template<class T>
-	inline T present_value(size_t m, const T* u, const T* c, size_t n, const T* t, const T* f, T _f = 0)
+	inline T present_value(size_t m, const T* u, const T* c, size_t n, const T* t, const T* f, T _f = 0) noexcept
 	{
 		T pv(0);
 
@@ -112,10 +172,25 @@ namespace pwflat {
 
 		return pv;
 	}
+	// uses the knot index of f if it has one
+	template<class T>
+	inline T present_value(size_t m, const T* u, const T* c, const forward_curve<T>& f) noexcept
+	{
+		if (!f.index)
+			return present_value(m, u, c, f.n, f.t, f.f, f._f);
+
+		T pv(0);
+
+		while (m--) {
+			pv += *c++ * exp(-f.index->integral(*u++, f._f));
+		}
+
+		return pv;
+	}
 	template<class T>
 	inline T present_value(const fixed_income::instrument<T>& i, const forward_curve<T>& f)
 	{
-		return present_value(i.n, i.t, i.c, f.n, f.t, f.f, f._f);
+		return present_value(i.n, i.t, i.c, f);
 	}
 	// present value given fractional recovery R and survival S(t) = P(T > t)
 	template<class T>
@@ -134,6 +209,26 @@ namespace pwflat {
 
 		return pv;
 	}
+	// fused kernel for survival given by a hazard curve, fastest for increasing times
+	template<class T>
+	inline T present_value(size_t m, const T* u, const T* c, const forward_curve<T>& f, T r, const hazard_curve<T>& h)
+	{
+		T pv(0);
+		integral_cursor<T> If(f), Ih(h);
+
+		while (m--) {
+			pv += *c * exp(-If(*u)) * (r + (1 - r)*exp(-Ih(*u)));
+			++u;
+			++c;
+		}
+
+		return pv;
+	}
+	template<class T>
+	inline T present_value(const fixed_income::instrument<T>& i, const forward_curve<T>& f, T r, const hazard_curve<T>& h)
+	{
+		return present_value(i.n, i.t, i.c, f, r, h);
+	}
 
 	// fixed coupon legs
 	// assumes c[0] is fixed coupon, c[i] are day count fractions
@@ -165,6 +260,21 @@ namespace pwflat {
 
 		return pv;
 	}
+	template<class T>
+	inline T present_value(const fixed_income::fixed_leg<T>& i, const forward_curve<T>& f, T r, const hazard_curve<T>& h)
+	{
+		T pv(0);
+		size_t m = i.n;
+		const T* u = i.t;
+		const T* c = i.c;
+		integral_cursor<T> If(f), Ih(h);
+
+		for (size_t i = 1; i < m; ++i) {
+			pv += c[0] * c[i] * exp(-If(u[i])) * (r + (1 - r)*exp(-Ih(u[i])));
+		}
+
+		return pv;
+	}
 
 	// floating coupon legs
 	template<class T>
@@ -187,6 +297,25 @@ namespace pwflat {
 
 		return pv;
 	}
+	template<class T>
+	inline T present_value(const fixed_income::float_leg<T>& i, const forward_curve<T>& f, T r, const hazard_curve<T>& h)
+	{
+		ensure (i.n > 0);
+
+		T pv(0);
+		size_t m = i.n;
+		const T* u = i.t;
+		integral_cursor<T> If(f), Ih(h);
+		T D0 = exp(-If(u[0]));
+
+		for (size_t i = 1; i < m; ++i) {
+			T D1 = exp(-If(u[i]));
+			pv += (D0 - D1) * (r + (1 - r)*exp(-Ih(u[i])));
+			D0 = D1;
+		}
+
+		return pv;
+	}
 
 	// d(pv)/df for parallel shift past u0
 	template<class T>
@@ -207,10 +336,55 @@ namespace pwflat {
 
 		return dur;
 	}
+
+	// pv and its first two derivatives for a parallel shift past u0
+	template<class T = double>
+	struct sensitivity {
+		T pv;
+		T dur;
+		T cvx;
+	};
+	// one pass over the flows with one discount each, flows sorted
+	template<class T>
+	inline sensitivity<T> sensitivities(size_t m, const T* u, const T* c, const forward_curve<T>& f, T u0 = 0) noexcept
+	{
+		integral_cursor<T> I(f);
+		sensitivity<T> s = {0, 0, 0};
+
+		for (size_t j = 0; j < m; ++j) {
+			T w = c[j]*exp(-I(u[j]));
+			s.pv += w;
+			if (u[j] > u0) {
+				T du = u[j] - u0;
+				s.dur -= du*w;
+				s.cvx += du*du*w;
+			}
+		}
+
+		return s;
+	}
+	template<class T>
+	inline sensitivity<T> sensitivities(const fixed_income::instrument<T>& i, const forward_curve<T>& f, T u0 = 0)
+	{
+		return sensitivities(i.n, i.t, i.c, f, u0);
+	}
+
 	template<class T>
 	inline T duration(const fixed_income::instrument<T>& i, const forward_curve<T>& f, T u0 = 0)
 	{
-		return duration(i.n, i.t, i.c, f.n, f.t, f.f, f._f, u0);
+		return sensitivities(i, f, u0).dur;
+	}
+
+	// d^2 pv/df^2 for parallel shift past u0
+	template<class T>
+	inline T convexity(size_t m, const T* u, const T* c, const forward_curve<T>& f, T u0 = 0)
+	{
+		return sensitivities(m, u, c, f, u0).cvx;
+	}
+	template<class T>
+	inline T convexity(const fixed_income::instrument<T>& i, const forward_curve<T>& f, T u0 = 0)
+	{
+		return convexity(i.n, i.t, i.c, f, u0);
 	}
 
 } // namespace pwflat
\ No newline at end of file
@@ -0,0 +1,240 @@
+// pwflat_risk.h - bucketed risk against the instruments used to bootstrap a curve
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <mutex>
+#include <vector>
+#include "ensure.h"
+#include "parallel.h"
+#include "pwflat.h"
+
+namespace pwflat {
+
+	// Accumulate d pv/d f[i] for cash flows on a piecewise flat curve.
+	// Since d/d f[i] int_0^u f = overlap of (t[i-1], t[i]] with (0, u], flows only
+	// need their discounted amount by segment: O(m) per instrument and O(n) for gradient().
+	template<class T = double>
+	class knot_gradient {
+		forward_curve<T> f_;
+		std::vector<T> W_; // sum of c D(u) for u in segment i, i = n is extrapolation
+		std::vector<T> P_; // sum of c D(u) (u - t[i-1]) for u in segment i
+		std::vector<T> Q_; // sum of c D(u) (u - t[i-1])^2 for u in segment i
+	public:
+		knot_gradient(const forward_curve<T>& f)
+			: f_(f), W_(f.n + 1), P_(f.n + 1), Q_(f.n + 1)
+		{ }
+
+		size_t size(void) const
+		{
+			return f_.n;
+		}
+		void clear(void)
+		{
+			std::fill(W_.begin(), W_.end(), T(0));
+			std::fill(P_.begin(), P_.end(), T(0));
+			std::fill(Q_.begin(), Q_.end(), T(0));
+		}
+		// cash flows a c at sorted times u
+		knot_gradient& add(size_t m, const T* u, const T* c, T a = 1) ENSURE_NOEXCEPT
+		{
+			integral_cursor<T> I(f_);
+			size_t i = 0;
+
+			for (size_t j = 0; j < m; ++j) {
+				ensure_debug (j == 0 || u[j] >= u[j-1]);
+				while (i < f_.n && f_.t[i] < u[j])
+					++i;
+				T w = a*c[j]*exp(-I(u[j]));
+				T o = u[j] - (i ? f_.t[i-1] : 0);
+				W_[i] += w;
+				P_[i] += w*o;
+				Q_[i] += w*o*o;
+			}
+
+			return *this;
+		}
+		knot_gradient& add(const fixed_income::instrument<T>& i, T a = 1)
+		{
+			return add(i.n, i.t, i.c, a);
+		}
+		knot_gradient& operator+=(const knot_gradient& g)
+		{
+			ensure (g.W_.size() == W_.size());
+
+			for (size_t i = 0; i < W_.size(); ++i) {
+				W_[i] += g.W_[i];
+				P_[i] += g.P_[i];
+				Q_[i] += g.Q_[i];
+			}
+
+			return *this;
+		}
+
+		// g[i] = d pv/d f[i], i < f.n
+		void gradient(T* g) const
+		{
+			T W(W_[f_.n]); // discounted flows past the knot
+
+			for (size_t i = f_.n; i--; ) {
+				g[i] = -(f_.t[i] - (i ? f_.t[i-1] : 0))*W - P_[i];
+				W += W_[i];
+			}
+		}
+		// H[i*n + k] = d^2 pv/d f[i] d f[k]
+		// For i < k every flow in segment k or later overlaps all of segment i, so H[i][k] = -dt[i] g[k].
+		void hessian(T* H) const
+		{
+			size_t n = f_.n;
+			std::vector<T> g(n);
+			gradient(n ? &g[0] : 0);
+
+			T W(W_[n]);
+			for (size_t k = n; k--; ) {
+				T dt = f_.t[k] - (k ? f_.t[k-1] : 0);
+				H[k*n + k] = dt*dt*W + Q_[k];
+				W += W_[k];
+				for (size_t i = 0; i < k; ++i)
+					H[i*n + k] = H[k*n + i] = -(f_.t[i] - (i ? f_.t[i-1] : 0))*g[k];
+			}
+		}
+	};
+
+	// Lower triangular A[k][i] = d pv_k/d f[i] where instrument k determined knot k,
+	// e.g. the instruments added to a yield_curve without jump dates.
+	// The instruments and curve are not owned and must outlive the Jacobian.
+	template<class T = double>
+	class bootstrap_jacobian {
+		size_t n_;
+		std::vector<T> A_;
+		const fixed_income::instrument<T>* i_; // for the instrument Hessians in gamma()
+		forward_curve<T> f_;
+	public:
+		bootstrap_jacobian(size_t n, const fixed_income::instrument<T>* i, const forward_curve<T>& f)
+			: n_(n), A_(n*n), i_(i), f_(f)
+		{
+			ensure (n == f.n);
+
+			knot_gradient<T> g(f);
+			for (size_t k = 0; k < n; ++k) {
+				ensure (i[k].n && i[k].t[i[k].n - 1] == f.t[k]);
+				g.clear();
+				g.add(i[k]).gradient(&A_[k*n]);
+				ensure (A_[k*n + k] != 0);
+			}
+		}
+
+		size_t size(void) const
+		{
+			return n_;
+		}
+		T operator()(size_t k, size_t i) const
+		{
+			return A_[k*n_ + i];
+		}
+
+		// solve A' x = g in place by back substitution
+		void adjoint(T* g) const
+		{
+			for (size_t k = n_; k--; ) {
+				for (size_t i = k + 1; i < n_; ++i)
+					g[k] -= A_[i*n_ + k]*g[i];
+				g[k] /= A_[k*n_ + k];
+			}
+		}
+
+		// Second derivative with respect to quotes given knot Hessian H and x = A'^-1 g
+		//
+		//	A'^-1 (H - sum_k x_k H_k) A^-1
+		//
+		// where H_k is the knot Hessian of instrument k. H is overwritten with the result.
+		// The Hessian is linear in the flows, so sum_k x_k H_k is the Hessian of the
+		// instruments scaled by x_k from one pass over their flows.
+		void gamma(const T* x, T* H) const
+		{
+			size_t n = n_;
+			std::vector<T> col(n), Hx(n*n);
+
+			knot_gradient<T> g(f_);
+			for (size_t k = 0; k < n; ++k)
+				g.add(i_[k], x[k]);
+			g.hessian(n ? &Hx[0] : 0);
+			for (size_t ij = 0; ij < n*n; ++ij)
+				H[ij] -= Hx[ij];
+
+			// A'^-1 on columns, then on rows of the symmetric result
+			for (int pass = 0; pass < 2; ++pass) {
+				for (size_t j = 0; j < n; ++j) {
+					for (size_t i = 0; i < n; ++i)
+						col[i] = H[i*n + j];
+					adjoint(&col[0]);
+					for (size_t i = 0; i < n; ++i)
+						H[i*n + j] = col[i];
+				}
+				for (size_t i = 0; i < n; ++i)
+					for (size_t j = 0; j < i; ++j)
+						std::swap(H[i*n + j], H[j*n + i]);
+			}
+		}
+	};
+
+	// Derivative of the portfolio value with respect to the quote of each curve instrument.
+	// Instrument k reprices to its price p_k, so d pv/d p_k = x_k where A' x = d pv/d f.
+	// If dq is not null the quotes are rates with dq[k] = d pv_k/d q_k, e.g. the annuity
+	// of a swap, and d pv/d q_k = -x_k dq[k]. Multiply by 0.0001 for DV01.
+	template<class T>
+	inline void bucket_risk(size_t ni, const fixed_income::instrument<T>* i, const forward_curve<T>& f,
+		const bootstrap_jacobian<T>& J, T* dpv, const T* dq = 0, size_t threads = std::thread::hardware_concurrency())
+	{
+		ensure (J.size() == f.n);
+
+		knot_gradient<T> g(f);
+		std::mutex m;
+
+		parallel::for_range(ni, [&](size_t b, size_t e) {
+			knot_gradient<T> gl(f);
+
+			for (size_t l = b; l < e; ++l)
+				gl.add(i[l]);
+
+			std::lock_guard<std::mutex> lock(m);
+			g += gl;
+		}, threads);
+
+		g.gradient(dpv);
+		J.adjoint(dpv);
+
+		if (dq) {
+			for (size_t k = 0; k < f.n; ++k)
+				dpv[k] *= -dq[k];
+		}
+	}
+
+	// Bucketed delta dpv and gamma, an n x n matrix, of the portfolio value with
+	// respect to the prices of the curve instruments from the same pass over the flows.
+	template<class T>
+	inline void bucket_gamma(size_t ni, const fixed_income::instrument<T>* i, const forward_curve<T>& f,
+		const bootstrap_jacobian<T>& J, T* dpv, T* gamma, size_t threads = std::thread::hardware_concurrency())
+	{
+		ensure (J.size() == f.n);
+
+		knot_gradient<T> g(f);
+		std::mutex m;
+
+		parallel::for_range(ni, [&](size_t b, size_t e) {
+			knot_gradient<T> gl(f);
+
+			for (size_t l = b; l < e; ++l)
+				gl.add(i[l]);
+
+			std::lock_guard<std::mutex> lock(m);
+			g += gl;
+		}, threads);
+
+		g.gradient(dpv);
+		g.hessian(gamma);
+		J.adjoint(dpv);
+		J.gamma(dpv, gamma);
+	}
+
+} // namespace pwflat
@@ -3,8 +3,10 @@
 #pragma once
 #include <cmath>
 #include <algorithm>
+#include <limits>
 #include <vector>
 #include "bootstrap.h"
+#include "futures_strip.h"
 
 namespace pwflat {
 
@@ -13,10 +15,74 @@ namespace pwflat {
 	class yield_curve {
 		std::vector<T> t_;
 		std::vector<T> f_;
+		std::vector<T> jump_;    // sorted exogenous knots
+		std::vector<T> s0_, s1_, s_; // spread overlays s_ on (s0_, s1_]
+		std::vector<T> st_, sf_; // piecewise flat sum of overlays, zero past st_.back()
+		std::vector<T> tm_, fm_; // curve plus overlays
+		std::vector<T> w_;       // scratch for try_add
 		void push_back(const T& t, const T& f)
 		{
 			t_.push_back(t);
 			f_.push_back(f);
+			merge(t_.size() - 1);
+		}
+		// append overlay knots in (t_[i-1], t_[i]) and t_[i] to the merged curve
+		void merge(size_t i)
+		{
+			if (st_.empty())
+				return;
+
+			T t0 = i ? t_[i-1] : 0;
+			auto j = std::upper_bound(st_.begin(), st_.end(), t0);
+			for (; j != st_.end() && *j < t_[i]; ++j) {
+				tm_.push_back(*j);
+				fm_.push_back(f_[i] + sf_[j - st_.begin()]);
+			}
+			tm_.push_back(t_[i]);
+			fm_.push_back(f_[i] + spread(t_[i]));
+		}
+		T spread(T u) const
+		{
+			return st_.empty() ? 0 : value(u, st_.size(), &st_[0], &sf_[0]);
+		}
+		// exp(-int_0^u spread)
+		T spread_discount(T u) const
+		{
+			return st_.empty() ? 1 : exp(-integral(u, st_.size(), &st_[0], &sf_[0]));
+		}
+		// curve without overlays
+		::pwflat::forward_curve<T> base_curve() const
+		{
+			return size() == 0? ::pwflat::forward_curve<T>() : ::pwflat::forward_curve<T>(t_.size(), &t_[0], &f_[0]);
+		}
+		// knots at jump dates in (maturity(), u) carry the forward f
+		void push_jumps(T u, T f)
+		{
+			T t0 = size() ? t_.back() : 0;
+
+			for (auto j = std::upper_bound(jump_.begin(), jump_.end(), t0); j != jump_.end() && *j < u; ++j)
+				push_back(*j, f);
+		}
+		// extend the curve to u with the forward from b() after pending jump dates
+		template<class B>
+		void extend(T u, const B& b)
+		{
+			if (size())
+				push_jumps(u, f_.back());
+
+			T f = b();
+
+			if (!size()) // first segment is split after it is known
+				push_jumps(u, f);
+
+			push_back(u, f);
+		}
+		bool jumps(T u) const
+		{
+			T t0 = size() ? t_.back() : 0;
+			auto j = std::upper_bound(jump_.begin(), jump_.end(), t0);
+
+			return j != jump_.end() && *j < u;
 		}
 	public:
 		/// <summary>Construct an empty yield curve.</summary>
@@ -29,19 +95,106 @@ namespace pwflat {
 		{
 			return t_.size();
 		}
+		// remove instruments, jump dates and spreads, e.g. before curve_graph rebuilds the curve
 		void reset(void)
 		{
 			t_.resize(0);
 			f_.resize(0);
+			jump_.resize(0);
+			s0_.resize(0);
+			s1_.resize(0);
+			s_.resize(0);
+			st_.resize(0);
+			sf_.resize(0);
+			tm_.resize(0);
+			fm_.resize(0);
 		}
 		T maturity(void) const
 		{
 			return t_.back();
 		}
+		// room for knots, including jump dates and overlay breakpoints, and flows per instrument
+		// so try_add does not allocate
+		yield_curve& reserve(size_t knots, size_t flows = 0)
+		{
+			t_.reserve(knots);
+			f_.reserve(knots);
+			tm_.reserve(knots);
+			fm_.reserve(knots);
+			w_.reserve(flows);
+
+			return *this;
+		}
 
+		/// <summary>The bootstrapped curve including spread overlays.</summary>
+		/// <remarks>
+		/// Overlay knots are merged into the curve so discounting costs the same
+		/// as a curve without overlays.
+		/// </remarks>
 		::pwflat::forward_curve<T> forward_curve() const
 		{
-			return size() == 0? ::pwflat::forward_curve<T>() : ::pwflat::forward_curve<T>(t_.size(), &t_[0], &f_[0]);
+			if (st_.empty() || size() == 0)
+				return base_curve();
+
+			return ::pwflat::forward_curve<T>(tm_.size(), &tm_[0], &fm_[0]);
+		}
+
+		/// <summary>Add a fixed knot, e.g. a central bank meeting date.</summary>
+		/// <param name="t">The time at which the forward may jump.</param>
+		/// <remarks>
+		/// The forward is flat from the previous knot to the jump date and the
+		/// next instrument determines the forward after it. Jump dates must be
+		/// added before instruments maturing past them.
+		/// </remarks>
+		yield_curve& add_jump(T t)
+		{
+			ensure (t > 0);
+			ensure (size() == 0 || t > maturity());
+
+			jump_.insert(std::upper_bound(jump_.begin(), jump_.end(), t), t);
+
+			return *this;
+		}
+		/// <summary>Add a spread to the forward on (t0, t1], e.g. a turn of year premium.</summary>
+		/// <param name="t0">The start of the spread period.</param>
+		/// <param name="t1">The end of the spread period.</param>
+		/// <param name="s">The continuously compounded spread.</param>
+		/// <remarks>
+		/// Instruments are priced on the curve plus spreads and the bootstrap
+		/// solves for the curve without them. Spreads must be added before
+		/// instruments maturing past t0.
+		/// </remarks>
+		yield_curve& add_spread(T t0, T t1, T s)
+		{
+			ensure (0 <= t0 && t0 < t1);
+			ensure (size() == 0 || t0 >= maturity());
+
+			if (st_.empty()) {
+				tm_ = t_;
+				fm_ = f_;
+			}
+
+			s0_.push_back(t0);
+			s1_.push_back(t1);
+			s_.push_back(s);
+
+			// breakpoints of the sum of overlays
+			st_ = s0_;
+			st_.insert(st_.end(), s1_.begin(), s1_.end());
+			std::sort(st_.begin(), st_.end());
+			st_.erase(std::unique(st_.begin(), st_.end()), st_.end());
+			if (st_[0] == 0)
+				st_.erase(st_.begin());
+
+			sf_.assign(st_.size(), 0);
+			for (size_t j = 0; j < st_.size(); ++j) {
+				T t_j = j ? st_[j-1] : 0;
+				for (size_t k = 0; k < s_.size(); ++k)
+					if (s0_[k] <= t_j && st_[j] <= s1_[k])
+						sf_[j] += s_[k];
+			}
+
+			return *this;
 		}
 
 		/// <summary>Add a cash deposit.</summary>
@@ -55,7 +208,7 @@ namespace pwflat {
 		/// </remarks>
 		yield_curve& add(T t0, T c0)
 		{
-			push_back(t0, bootstrap(t0, c0, forward_curve()));
+			extend(t0, [&]() { return bootstrap1(t0, c0*spread_discount(t0), base_curve()); });
 
 			return *this;
 		}
@@ -72,7 +225,9 @@ namespace pwflat {
 		/// </remarks>
 		yield_curve& add(T t0, T c0, T t1, T c1)
 		{
-			push_back(t1, bootstrap(t0, c0, t1, c1, forward_curve()));
+			extend(t1, [&]() {
+				return bootstrap2(t0, c0*spread_discount(t0), t1, c1*spread_discount(t1), base_curve());
+			});
 
 			return *this;
 		}
@@ -84,7 +239,16 @@ namespace pwflat {
 		/// <param name="p">Optional price of instrument. Default is 0.</param>
 		yield_curve& add(size_t n, const T* tb, const T* cb, T _f = 0, T p = 0)
 		{
- 			push_back(tb[n - 1], bootstrap(fixed_income::instrument<T>(n, tb, cb), forward_curve(), _f, p));
+			std::vector<T> c;
+
+			if (!st_.empty()) {
+				c.resize(n);
+				for (size_t i = 0; i < n; ++i)
+					c[i] = cb[i]*spread_discount(tb[i]);
+				cb = &c[0];
+			}
+
+			extend(tb[n - 1], [&]() { return bootstrap(fixed_income::instrument<T>(n, tb, cb), base_curve(), _f, p); });
 
 			return *this;
 		}
@@ -93,6 +257,115 @@ namespace pwflat {
 		{
 			return add(i.n, i.t, i.c, _f, p);
 		}
+		/// <summary>Add a general cash flow stream without throwing.</summary>
+		/// <param name="n">The number of cash flows.</param>
+		/// <param name="tb">Pointer to the cash flow times in years.</param>
+		/// <param name="cb">Pointer to the cash flow amounts.</param>
+		/// <param name="_f">Optional initial guess for boostrap.</param>
+		/// <param name="p">Optional price of instrument. Default is 0.</param>
+		/// <remarks>
+		/// One cash flow is a cash deposit and two with price 0 are a forward rate agreement,
+		/// as for add. If the status is not converged the curve is left as it was.
+		/// Nothing is allocated if reserve() made room for the knots and flows, otherwise
+		/// growing the curve may throw std::bad_alloc.
+		/// </remarks>
+		bootstrap_status<T> try_add(size_t n, const T* tb, const T* cb, T _f = 0, T p = 0)
+		{
+			bootstrap_status<T> s = {false, 0, std::numeric_limits<T>::quiet_NaN(), 0, {0, 0, 0}};
+
+			// input checks do not depend on ENSURE_LEVEL
+			if (!ensure_status(n != 0, &s.check) || !ensure_status(size() == 0 || tb[n-1] > maturity(), &s.check))
+				return s;
+
+			if (!st_.empty()) {
+				w_.resize(n);
+				for (size_t i = 0; i < n; ++i)
+					w_[i] = cb[i]*spread_discount(tb[i]);
+				cb = &w_[0];
+			}
+
+			size_t k = t_.size(), km = tm_.size();
+			extend(tb[n - 1], [&]() {
+				::pwflat::forward_curve<T> f = base_curve();
+				T x = _f;
+				s = bootstrap_try(n, tb, cb, f.n, f.t, f.f, x, p);
+
+				return x;
+			});
+			if (!s.converged) { // jump knots pushed before the failure go too
+				t_.resize(k);
+				f_.resize(k);
+				tm_.resize(km);
+				fm_.resize(km);
+			}
+
+			return s;
+		}
+		template<class D>
+		bootstrap_status<T> try_add(const fixed_income::instrument<T,D>& i, T _f = 0, T p = 0)
+		{
+			return try_add(i.n, i.t, i.c, _f, p);
+		}
+		/// <summary>Add instruments in order until one fails.</summary>
+		/// <param name="m">The number of instruments.</param>
+		/// <param name="i">Pointer to the instruments.</param>
+		/// <param name="p">Optional pointer to the instrument prices. Default is 0.</param>
+		/// <remarks>
+		/// Returns the status of the first failure with its index and the curve holds the
+		/// instruments before it. Otherwise iterations is the total and residual the largest.
+		/// </remarks>
+		template<class D>
+		bootstrap_status<T> try_add(size_t m, const fixed_income::instrument<T,D>* i, const T* p = 0)
+		{
+			bootstrap_status<T> s = {true, 0, 0, static_cast<size_t>(-1), {0, 0, 0}};
+
+			for (size_t k = 0; k < m; ++k) {
+				bootstrap_status<T> sk = try_add(i[k], 0, p ? p[k] : 0);
+				if (!sk.converged) {
+					sk.iterations += s.iterations;
+					sk.index = k;
+
+					return sk;
+				}
+				s.iterations += sk.iterations;
+				if (fabs(sk.residual) > fabs(s.residual))
+					s.residual = sk.residual;
+			}
+
+			return s;
+		}
+		/// <summary>Add a strip of futures or forward rate agreements in one pass.</summary>
+		/// <param name="m">The number of periods.</param>
+		/// <param name="u0">Pointer to the sorted period start times.</param>
+		/// <param name="u1">Pointer to the sorted period end times.</param>
+		/// <param name="d">Pointer to the period growth, e.g. 1 + r*dcf.</param>
+		yield_curve& add_strip(size_t m, const T* u0, const T* u1, const T* d)
+		{
+			if (m == 0)
+				return *this;
+			check_strip(m, u0, u1, d, size() ? maturity() : 0); // before the curve changes
+
+			std::vector<T> d_(d, d + m);
+			for (size_t k = 0; k < m; ++k)
+				d_[k] *= spread_discount(u1[k])/spread_discount(u0[k]);
+
+			if (jumps(u1[m-1])) {
+				for (size_t k = 0; k < m; ++k)
+					extend(u1[k], [&]() { return bootstrap2(u0[k], T(-1), u1[k], d_[k], base_curve()); });
+
+				return *this;
+			}
+
+			size_t n = t_.size();
+
+			t_.resize(n + m);
+			f_.resize(n + m);
+			bootstrap_strip(m, u0, u1, &d_[0], n, &t_[0], &f_[0]);
+			for (size_t i = n; i < n + m; ++i)
+				merge(i);
+
+			return *this;
+		}
 	};
 
 } // namespace pwflat
@@ -0,0 +1,148 @@
+// pwlinear.h - piecewise linear forward curve
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "bootstrap.h"
+#include "forward_curve.h"
+
+namespace pwlinear {
+
+	// f(u) = f[0], u <= t[0]
+	// f(u) linear from f[i-1] to f[i], t[i-1] < u <= t[i]
+	// f(u) = f[n-1], u > t[n-1]
+	// Integrals at knots are stored so integral() and discount() are O(log n).
+	template<class T = double>
+	class forward_curve : public fixed_income::forward_curve<T,T> {
+		std::vector<T> t_;
+		std::vector<T> f_;
+		std::vector<T> I_; // I_[i] = int_0^t_[i] f(s) ds
+	public:
+		forward_curve()
+		{ }
+		forward_curve(size_t n, const T* t, const T* f)
+		{
+			for (size_t i = 0; i < n; ++i)
+				push_back(t[i], f[i]);
+		}
+		virtual ~forward_curve()
+		{ }
+
+		size_t size(void) const
+		{
+			return t_.size();
+		}
+		const T* time(void) const
+		{
+			return t_.empty() ? 0 : &t_[0];
+		}
+		const T* rate(void) const
+		{
+			return f_.empty() ? 0 : &f_[0];
+		}
+
+		void push_back(T t, T f)
+		{
+			ensure (t_.empty() || t > t_.back());
+
+			T I = t_.empty() ? f*t : I_.back() + (t - t_.back())*(f_.back() + f)/2;
+
+			t_.push_back(t);
+			f_.push_back(f);
+			I_.push_back(I);
+		}
+
+		T value(const T& u) const
+		{
+			size_t i = std::lower_bound(t_.begin(), t_.end(), u) - t_.begin();
+
+			if (i == t_.size())
+				return t_.empty() ? 0 : f_.back();
+			if (i == 0)
+				return f_[0];
+
+			return f_[i-1] + (f_[i] - f_[i-1])*(u - t_[i-1])/(t_[i] - t_[i-1]);
+		}
+		T operator()(T u) const
+		{
+			return value(u);
+		}
+		T integral(const T& u) const
+		{
+			size_t i = std::lower_bound(t_.begin(), t_.end(), u) - t_.begin();
+
+			if (i == t_.size())
+				return t_.empty() ? 0 : I_.back() + f_.back()*(u - t_.back());
+			if (i == 0)
+				return f_[0]*u;
+
+			return I_[i-1] + (u - t_[i-1])*(f_[i-1] + value(u))/2;
+		}
+		T discount(T u) const
+		{
+			return exp(-integral(u));
+		}
+
+		// int_0^u f = a + b x if the next knot is (t1, x), u <= t1
+		void affine(T u, T t1, T* a, T* b) const
+		{
+			T t0 = t_.empty() ? 0 : t_.back();
+
+			if (u <= t0) {
+				*a = integral(u);
+				*b = 0;
+			}
+			else if (t_.empty()) {
+				*a = 0;
+				*b = u;
+			}
+			else {
+				T s = u - t0;
+				T s2h = s*s/(2*(t1 - t0));
+
+				*a = I_.back() + f_.back()*(s - s2h);
+				*b = s2h;
+			}
+		}
+
+		// add a knot at the last cash flow time so the instrument has price p
+		forward_curve& add(size_t m, const T* u, const T* c, T x = 0, T p = 0)
+		{
+			ensure (m && (t_.empty() || u[m-1] > t_.back()));
+
+			std::vector<T> a(m), b(m);
+			for (size_t j = 0; j < m; ++j)
+				affine(u[j], u[m-1], &a[j], &b[j]);
+
+			if (x == 0)
+				x = t_.empty() ? static_cast<T>(0.01) : f_.back();
+
+			push_back(u[m-1], pwflat::bootstrap_affine(m, &a[0], &b[0], c, x, p));
+
+			return *this;
+		}
+		template<class D>
+		forward_curve& add(const fixed_income::instrument<T,D>& i, T x = 0, T p = 0)
+		{
+			return add(i.n, i.t, i.c, x, p);
+		}
+	};
+
+	template<class T>
+	inline T value(T u, const forward_curve<T>& f)
+	{
+		return f.value(u);
+	}
+	template<class T>
+	inline T integral(T u, const forward_curve<T>& f)
+	{
+		return f.integral(u);
+	}
+	template<class T>
+	inline T discount(T u, const forward_curve<T>& f)
+	{
+		return f.discount(u);
+	}
+
+} // namespace pwlinear
@@ -0,0 +1,127 @@
+// roll_down.h - time shifted curves, carry and roll-down
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "ensure.h"
+#include "day_instrument.h"
+#include "discount_cache.h"
+#include "parallel.h"
+#include "pwflat.h"
+
+namespace pwflat {
+
+	// Curve seen from time s when the forwards are realized: f_s(u) = f(s + u).
+	// O(1) view of f, which must outlive it.
+	template<class T = double>
+	class shifted_curve {
+		forward_curve<T> f_;
+		T s_, Is_; // Is_ = int_0^s f
+	public:
+		shifted_curve(const forward_curve<T>& f, T s)
+			: f_(f), s_(s), Is_(f.integral(s))
+		{ }
+
+		T shift(void) const
+		{
+			return s_;
+		}
+		T value(T u) const
+		{
+			return f_.value(s_ + u);
+		}
+		T operator()(T u) const
+		{
+			return value(u);
+		}
+		T integral(T u) const
+		{
+			return f_.integral(s_ + u) - Is_;
+		}
+		T discount(T u) const
+		{
+			return exp(-integral(u));
+		}
+	};
+
+	// Knots of the curve shifted by s written to t_ and f_, which need room for f.n knots.
+	// Returns the number of knots. Extrapolation is unchanged.
+	template<class T>
+	inline size_t shift(T s, const forward_curve<T>& f, T* t_, T* f_)
+	{
+		const T* ti = std::upper_bound(f.t, f.t + f.n, s);
+		size_t n = f.t + f.n - ti;
+
+		for (size_t i = 0; i < n; ++i) {
+			t_[i] = ti[i] - s;
+			f_[i] = f.f[ti - f.t + i];
+		}
+
+		return n;
+	}
+
+	enum roll_down_curve {
+		ROLL_DOWN_STATIC,  // curve is unchanged in time to maturity
+		ROLL_DOWN_FORWARD, // forwards are realized
+	};
+
+	// Value at day v + k[j] of the flows on or after that day for sorted day offsets k.
+	// pv is an nk x ni date major matrix. If cash is not null it gets the sum of
+	// flows on days in [v, v + k[j]), so carry and roll-down P&L is pv + cash - pv(k = 0).
+	template<class T>
+	inline void roll_down(size_t ni, const fixed_income::day_instrument<T>* i, int v,
+		size_t nk, const int* k, const forward_curve<T>& f, roll_down_curve curve,
+		T* pv, T* cash = 0, size_t threads = std::thread::hardware_concurrency())
+	{
+		ensure (std::is_sorted(k, k + nk));
+		ensure (nk == 0 || k[0] >= 0);
+
+		// discount to every day of the horizon in one pass
+		int days = nk ? k[nk - 1] + 1 : 1;
+		for (size_t l = 0; l < ni; ++l)
+			for (size_t j = 0; j < i[l].n; ++j)
+				days = std::max(days, i[l].d[j] - v + 1);
+
+		discount_cache<T> D(static_cast<size_t>(days));
+		D.bind(f, 0).fill();
+
+		parallel::for_range(ni, [&](size_t b, size_t e) {
+			for (size_t l = b; l < e; ++l) {
+				const fixed_income::day_instrument<T>& il = i[l];
+				ensure_debug (std::is_sorted(il.d, il.d + il.n));
+
+				// walk flows and dates backwards
+				size_t m = il.n;
+				T S(0), C(0);
+				for (size_t j = 0; j < il.n; ++j)
+					if (il.d[j] >= v)
+						C += il.c[j];
+
+				for (size_t kj = nk; kj--; ) {
+					int vk = v + k[kj];
+
+					while (m && il.d[m - 1] >= vk) {
+						--m;
+						if (curve == ROLL_DOWN_FORWARD)
+							S += il.c[m]*D(il.d[m] - v);
+						C -= il.c[m];
+					}
+
+					if (curve == ROLL_DOWN_FORWARD) {
+						pv[kj*ni + l] = S/D(k[kj]);
+					}
+					else {
+						T pvk(0);
+						for (size_t j = m; j < il.n; ++j)
+							pvk += il.c[j]*D(il.d[j] - vk);
+						pv[kj*ni + l] = pvk;
+					}
+					if (cash)
+						cash[kj*ni + l] = C;
+				}
+			}
+		}, threads);
+	}
+
+} // namespace pwflat
@@ -0,0 +1,171 @@
+// schedule_cache.h - calendar adjusted payment schedules shared between instruments
+// Copyright (c) 2013 KALX, LLC. All rights reserved.
+#pragma once
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <tuple>
+#include <vector>
+#include "datetime.h"
+#include "ensure.h"
+
+using datetime::date;
+using datetime::holiday_calendar;
+
+namespace fixed_income {
+
+	// Immutable schedule of times in years from the start date.
+	// t[0] is the settlement date and dcf[0] = 0. For i > 0, t[i] is a payment date
+	// and dcf[i] the day count fraction from the previous date.
+	// Assumes diffyears is additive so times from any valuation date are a shift of t.
+	template<class T = double>
+	struct schedule {
+		std::vector<T> t;
+		std::vector<T> dcf;
+
+		size_t size(void) const
+		{
+			return t.size();
+		}
+	};
+
+	// Key is start, settlement days, count, unit, frequency, roll, calendar, day count basis.
+	// Holds at most capacity() schedules and evicts the least recently used, so keys on
+	// new valuation dates do not grow it without bound. Evicted schedules stay valid for
+	// instruments holding them.
+	template<class T = double>
+	class schedule_cache {
+		typedef std::tuple<int,int,int,int,int,int,holiday_calendar,int> key;
+		typedef std::list<key> lru;
+		std::map<key, std::pair<std::shared_ptr<const schedule<T>>, typename lru::iterator>> map_;
+		lru lru_; // most recently used first
+		size_t capacity_;
+		mutable std::mutex mutex_;
+
+		static std::shared_ptr<const schedule<T>> make(const date& start, int settle,
+			int count, datetime::time_unit unit, datetime::payment_frequency freq,
+			datetime::roll_convention roll, const holiday_calendar& cal, datetime::day_count_basis dcb)
+		{
+			std::shared_ptr<schedule<T>> s = std::make_shared<schedule<T>>();
+
+			date d0(start);
+			if (settle)
+				d0.incr(settle, datetime::UNIT_DAYS).adjust(roll, cal);
+			s->t.push_back(static_cast<T>(d0.diffyears(start)));
+			s->dcf.push_back(0);
+
+			date mat(start);
+			mat.incr(count, unit).adjust(roll, cal);
+
+			if (freq == datetime::FREQ_NONE) {
+				s->t.push_back(static_cast<T>(mat.diffyears(start)));
+				s->dcf.push_back(static_cast<T>(mat.diff_dcb(d0, dcb)));
+			}
+			else {
+				for (int i = 1; d0 < mat; ++i) {
+					date d1(start);
+					d1.incr(12*i/freq, datetime::UNIT_MONTHS).adjust(roll, cal);
+					if (!(d1 < mat)) // short last period ends at maturity
+						d1 = mat;
+					s->t.push_back(static_cast<T>(d1.diffyears(start)));
+					s->dcf.push_back(static_cast<T>(d1.diff_dcb(d0, dcb)));
+					d0 = d1;
+				}
+			}
+
+			return s;
+		}
+		// call with the lock held
+		void evict(void)
+		{
+			while (map_.size() > capacity_) {
+				map_.erase(lru_.back());
+				lru_.pop_back();
+			}
+		}
+	public:
+		explicit schedule_cache(size_t capacity = 4096)
+			: capacity_(capacity)
+		{
+			ensure (capacity > 0);
+		}
+		schedule_cache(const schedule_cache&) = delete;
+		schedule_cache& operator=(const schedule_cache&) = delete;
+
+		size_t size(void) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			return map_.size();
+		}
+		void clear(void)
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			map_.clear();
+			lru_.clear();
+		}
+		size_t capacity(void) const
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			return capacity_;
+		}
+		// evicts the least recently used schedules if over the new capacity
+		void capacity(size_t n)
+		{
+			ensure (n > 0);
+			std::lock_guard<std::mutex> lock(mutex_);
+
+			capacity_ = n;
+			evict();
+		}
+
+		// datetime::FREQ_NONE gives a single period from settlement to maturity
+		std::shared_ptr<const schedule<T>> get(const date& start, int settle,
+			int count, datetime::time_unit unit, datetime::payment_frequency freq,
+			datetime::roll_convention roll, const holiday_calendar& cal, datetime::day_count_basis dcb)
+		{
+			int y, m, d;
+			start.localtime(&y, &m, &d);
+			key k(10000*y + 100*m + d, settle, count, unit, freq, roll, cal, dcb);
+
+			{
+				std::lock_guard<std::mutex> lock(mutex_);
+				auto i = map_.find(k);
+				if (i != map_.end()) {
+					lru_.splice(lru_.begin(), lru_, i->second.second);
+
+					return i->second.first;
+				}
+			}
+
+			// build outside the lock, first one in wins
+			std::shared_ptr<const schedule<T>> s = make(start, settle, count, unit, freq, roll, cal, dcb);
+
+			std::lock_guard<std::mutex> lock(mutex_);
+			auto i = map_.find(k);
+			if (i != map_.end()) {
+				lru_.splice(lru_.begin(), lru_, i->second.second);
+
+				return i->second.first;
+			}
+			lru_.push_front(k);
+			map_.insert(std::make_pair(k, std::make_pair(s, lru_.begin())));
+			evict();
+
+			return s;
+		}
+	};
+
+	// cache shared by all instruments, bounded by capacity()
+	template<class T>
+	inline schedule_cache<T>& schedules(void)
+	{
+		static schedule_cache<T> cache;
+
+		return cache;
+	}
+
+} // namespace fixed_income
@@ -1,5 +1,10 @@
 // secant.h - 1-d secant root finding
 #pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <limits>
+#include "ensure.h"
 
 namespace root1d {
 
@@ -29,7 +34,8 @@ namespace root1d {
 		}
 		Y step(void)
 		{
-			ensure (iter_-- != 0);
+			ensure (iter_ != 0);
+			--iter_;
 			ensure (fabs(x1_ - x0_) > std::numeric_limits<X>::epsilon());
 
 			Y m = (y1_ - y0_)/(x1_ - x0_);
@@ -2,6 +2,11 @@
 // Copyright (c) 2011 KALX, LLC. All rights reserved. No warranty made.
 #include <cassert>
 #include <iostream>
+#include "../ensure.h"
+
+#if ENSURE_LEVEL < 1 // the tests check with ensure
+#error "build the tests with ENSURE_LEVEL_MIN=1"
+#endif
 
 using namespace std;
 
@@ -16,6 +21,22 @@ void fms_test_valuation();
 void fms_test_bootstrap();
 //void fms_test_fixed_income();
 void fms_test_pwflat();
+void fms_test_curve_graph(void);
+void fms_test_credit_curve(void);
+void fms_test_hull_white(void);
+void fms_test_exposure(void);
+void fms_test_schedule_cache(void);
+void fms_test_arena(void);
+void fms_test_futures_strip(void);
+void fms_test_smooth_curve(void);
+void fms_test_knot_index(void);
+void fms_test_discount_cache(void);
+void fms_test_day_instrument(void);
+void fms_test_roll_down(void);
+void fms_test_risk(void);
+void fms_test_batch_fix(void);
+void fms_test_integral_grid(void);
+void fms_test_ensure(void);
 
 
 int
@@ -31,6 +52,22 @@ main(void)
 		fms_test_bootstrap();
 //		fms_test_fixed_income();
 		fms_test_pwflat();
+		fms_test_curve_graph();
+		fms_test_credit_curve();
+		fms_test_hull_white();
+		fms_test_exposure();
+		fms_test_schedule_cache();
+		fms_test_arena();
+		fms_test_futures_strip();
+		fms_test_smooth_curve();
+		fms_test_knot_index();
+		fms_test_discount_cache();
+		fms_test_day_instrument();
+		fms_test_roll_down();
+		fms_test_risk();
+		fms_test_batch_fix();
+		fms_test_integral_grid();
+		fms_test_ensure();
 	}
 	catch (const std::exception& ex) {
 		std::cerr << ex.what() << std::endl;
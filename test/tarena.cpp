@@ -0,0 +1,64 @@
+// tarena.cpp - test arena allocation of cash flows
+#include <cstdint>
+#include "../ensure.h"
+#include "../arena.h"
+#include "../interest_rate_swap.h"
+
+using namespace fixed_income;
+
+void
+test_arena(void)
+{
+	arena a(1024);
+
+	char* p0 = static_cast<char*>(a.allocate(3, 1));
+	double* p1 = static_cast<double*>(a.allocate(sizeof(double), alignof(double)));
+	ensure (reinterpret_cast<uintptr_t>(p1) % alignof(double) == 0);
+	ensure (reinterpret_cast<char*>(p1) > p0);
+
+	// larger than a block
+	void* p2 = a.allocate(4096, 16);
+	ensure (reinterpret_cast<uintptr_t>(p2) % 16 == 0);
+	size_t cap = a.capacity();
+	ensure (cap >= 1024 + 4096);
+
+	// reset reuses the same memory
+	a.reset();
+	ensure (a.allocate(3, 1) == p0);
+	ensure (a.allocate(4096, 16) == p2);
+	ensure (a.capacity() == cap);
+
+	arena_allocator<double> alloc(a);
+	std::vector<double, arena_allocator<double>> v(alloc);
+	for (int i = 0; i < 100; ++i)
+		v.push_back(i);
+	ensure (v[99] == 99);
+}
+
+void
+test_arena_instrument(void)
+{
+	arena a;
+	arena_allocator<double> alloc(a);
+	date val(2012, 11, 11);
+	date eff(date(val).incr(2, datetime::UNIT_DAYS));
+
+	interest_rate_swap<> irs(eff, 10, datetime::UNIT_YEARS);
+	interest_rate_swap<double, arena_allocator<double>> irs_(eff, 10, datetime::UNIT_YEARS,
+		datetime::FREQ_SEMIANNUALLY, datetime::DCB_30U_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE, datetime::FREQ_QUARTERLY, datetime::DCB_ACTUAL_360, alloc);
+
+	irs.fix(val, 0.04);
+	irs_.fix(val, 0.04);
+	ensure (irs.n == irs_.n);
+	for (size_t i = 0; i < irs.n; ++i) {
+		ensure (irs.t[i] == irs_.t[i]);
+		ensure (irs.c[i] == irs_.c[i]);
+	}
+}
+
+void
+fms_test_arena(void)
+{
+	test_arena();
+	test_arena_instrument();
+}
@@ -0,0 +1,69 @@
+// tbatch_fix.cpp - test fixing instrument sets in one call
+#include <cmath>
+#include <vector>
+#include "../ensure.h"
+#include "../batch_fix.h"
+#include "../cash_deposit.h"
+#include "../forward_rate_agreement.h"
+#include "../interest_rate_swap.h"
+
+using namespace fixed_income;
+
+template<class D>
+static void
+check(const instrument<>& a, const instrument<double,D>& b)
+{
+	ensure (a.n == b.n);
+	for (size_t j = 0; j < a.n; ++j) {
+		ensure (a.t[j] == b.t[j]);
+		ensure (a.c[j] == b.c[j]);
+	}
+}
+
+void
+fms_test_batch_fix(void)
+{
+	date val(2012, 11, 11);
+	date eff(date(val).incr(2, datetime::UNIT_DAYS));
+
+	std::vector<indicative<>> r;
+	indicative<> cd = {INSTRUMENT_CASH_DEPOSIT, 2, date(), 3, datetime::UNIT_MONTHS, datetime::FREQ_NONE, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE, 0.01};
+	r.push_back(cd);
+	indicative<> fra = {INSTRUMENT_FORWARD_RATE_AGREEMENT, 0, date(eff).incr(3, datetime::UNIT_MONTHS), 3, datetime::UNIT_MONTHS, datetime::FREQ_NONE, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE, 0.02};
+	r.push_back(fra);
+	for (int y = 1; y <= 10; ++y) {
+		indicative<> irs = {INSTRUMENT_INTEREST_RATE_SWAP, 0, eff, y, datetime::UNIT_YEARS, datetime::FREQ_SEMIANNUALLY, datetime::DCB_30U_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE, 0.03 + 0.001*y};
+		r.push_back(irs);
+	}
+	// same conventions as the first swap
+	r.push_back(r[2]);
+	r.back().quote_ = 0.05;
+
+	batch_fixing<> b(val, r.size(), &r[0]);
+	ensure (b.size() == r.size());
+	ensure (b.offset(0) == 0 && b.offset(1) == 2 && b.offset(2) == 4);
+	ensure (b(2, 0, 0).n == 3 && b(11, 0, 0).n == 21);
+
+	std::vector<double> t(b.flows()), c(b.flows());
+	for (size_t threads = 1; threads <= 4; threads += 3) {
+		std::fill(t.begin(), t.end(), 0.);
+		b.fix(&r[0], &t[0], &c[0], threads);
+
+		cash_deposit<> cd0(2, 3, datetime::UNIT_MONTHS, datetime::DCB_ACTUAL_360);
+		check(b(0, &t[0], &c[0]), cd0.fix(val, 0.01));
+		forward_rate_agreement<> fra0(r[1].eff_, 3, datetime::UNIT_MONTHS);
+		check(b(1, &t[0], &c[0]), fra0.fix(val, 0.02));
+		for (int y = 1; y <= 10; ++y) {
+			interest_rate_swap<> irs(eff, y, datetime::UNIT_YEARS);
+			check(b(y + 1, &t[0], &c[0]), irs.fix(val, 0.03 + 0.001*y));
+		}
+		interest_rate_swap<> irs(eff, 1, datetime::UNIT_YEARS);
+		check(b(12, &t[0], &c[0]), irs.fix(val, 0.05));
+	}
+
+	// new quote snapshot reuses the schedules
+	r[0].quote_ = 0.011;
+	b.fix(&r[0], &t[0], &c[0], 1);
+	cash_deposit<> cd1(2, 3, datetime::UNIT_MONTHS, datetime::DCB_ACTUAL_360);
+	check(b(0, &t[0], &c[0]), cd1.fix(val, 0.011));
+}
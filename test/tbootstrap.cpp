@@ -1,8 +1,7 @@
 // tbootstrap.cpp - test bootstrap routines
-#include <cassert>
 #include <cmath>
+#include <cstring>
 #include <vector>
-#define ensure(x) assert(x)
 #include "../bootstrap.h"
 //#include "../instrument.h"
 
@@ -41,6 +40,82 @@ test_bootstrap(void)
 	T c4[] = {-1, e, e, e, 1 + e};
 	f.push_back(bootstrap(instrument<T>(5, u, c4), forward_curve<T>(3, t, &f[0]), (T).02)); 
 	ensure (fabs(f.back() - f0) < eps);
+
+	// flows past the last knot recover the rate that priced them
+	T tau[] = {(T)0.5, 1, (T)1.5};
+	T K = e*exp(-f0*tau[0]) + e*exp(-f0*tau[1]) + (1 + e)*exp(-f0*tau[2]);
+	T c5[] = {e, e, 1 + e};
+	ensure (fabs(bootstrap_tail<T>(3, tau, c5, K, (T).02) - f0) < 4*eps);
+	// same from the flow times and the last knot
+	T u5[] = {(T)2.5, 3, (T)3.5};
+	ensure (fabs(bootstrap_tail<T>(3, u5, c5, K, (T).02, 0, 0, (T)2) - f0) < 4*eps);
+
+	// equal spacing is a polynomial in exp(-f dt)
+	T dt;
+	ensure (equal_spacing<T>(3, tau, dt) == 1 && dt == (T)0.5);
+	T tau2[] = {1, (T)1.5, 2};
+	ensure (equal_spacing<T>(3, tau2, dt) == 2 && dt == (T)0.5);
+	T tau3[] = {(T)0.25, (T)0.75, (T)1.5};
+	ensure (equal_spacing<T>(3, tau3, dt) == 0);
+	ensure (equal_spacing<T>(3, u5, dt, (T)2) == 1 && dt == (T)0.5);
+	for (size_t m = 1; m <= 3; ++m) {
+		for (size_t k = 1; k <= 2; ++k) {
+			T Km(0);
+			for (size_t j = 0; j < m; ++j)
+				Km += c5[j]*pow(exp(-f0/2), static_cast<T>(k + j));
+			T z = bootstrap_polynomial<T>(m, k, c5, Km, (T)0.99);
+			ensure (fabs(-log(z)*2 - f0) < 8*eps);
+		}
+	}
+	// negative rates have z > 1, a poor guess stays in the bracket
+	{
+		T fn = (T)-0.01;
+		T Km(0);
+		for (size_t j = 0; j < 3; ++j)
+			Km += c5[j]*pow(exp(-fn/2), static_cast<T>(1 + j));
+		size_t steps = 0;
+		T z = bootstrap_polynomial<T>(3, 1, c5, Km, (T)0.01, &steps);
+		ensure (z > 1 && steps > 0);
+		ensure (fabs(-log(z)*2 - fn) < 64*eps);
+	}
+
+	// status instead of exceptions or NaN
+	{
+		T x = (T)0.02;
+		bootstrap_status<T> s = bootstrap_try<T>(5, u, c4, 1, t, &f[0], x);
+		ensure (s.converged && s.index == static_cast<size_t>(-1) && s.check.file == 0);
+		ensure (s.iterations > 0 && fabs(s.residual) < 16*eps);
+		ensure (fabs(x - f0) < eps);
+
+		x = 0;
+		s = bootstrap_try<T>(1, u + 1, c3 + 3, 0, t, &f[0], x);
+		ensure (s.converged && s.iterations == 0 && fabs(x - f0) < eps);
+
+		// no positive flows to offset
+		T u6[] = {5, 6, 7}, c6[] = {1, 1, 1};
+		x = (T)0.03;
+		s = bootstrap_try<T>(3, u6, c6, 4, t, &f[0], x);
+		ensure (!s.converged && s.index == 0 && s.check.file == 0);
+		ensure (x == (T)0.03);
+
+		// wrong sign fra
+		s = bootstrap_try<T>(2, u6, c6, 4, t, &f[0], x);
+		ensure (!s.converged && s.iterations == 0 && x == (T)0.03);
+
+		// matures before the last knot
+		s = bootstrap_try<T>(3, u, c3, 4, t, &f[0], x);
+		ensure (!s.converged && s.iterations == 0);
+		ensure (s.check.file != 0 && s.check.line > 0);
+		ensure (strcmp(s.check.expr, "n == 0 || u[m-1] > t[n-1]") == 0);
+
+		// no flows, and a cash deposit with a negative flow
+		s = bootstrap_try<T>(0, u, c3, 4, t, &f[0], x);
+		ensure (!s.converged && strcmp(s.check.expr, "m != 0") == 0);
+		T c7[] = {-1};
+		s = bootstrap_try<T>(1, u6, c7, 4, t, &f[0], x);
+		ensure (!s.converged && strcmp(s.check.expr, "m != 1 || (u[0] > 0 && c[0] > 0)") == 0);
+		ensure (x == (T)0.03);
+	}
 }
 
 void
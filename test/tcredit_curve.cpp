@@ -0,0 +1,74 @@
+// tcredit_curve.cpp - test hazard rate bootstrap
+#include <cmath>
+#include "../ensure.h"
+#include "../credit_curve.h"
+
+using namespace pwflat;
+
+template<class T>
+void
+test_credit_curve(void)
+{
+	T eps = 100*std::numeric_limits<T>::epsilon();
+	T R = static_cast<T>(0.4);
+
+	// discount curve
+	T t[] = {1, 2, 5};
+	T f[] = {static_cast<T>(0.01), static_cast<T>(0.02), static_cast<T>(0.03)};
+	forward_curve<T> F(3, t, f, static_cast<T>(0.03));
+
+	// quarterly premium dates out to 5 years
+	T u[20], a[20];
+	for (int j = 0; j < 20; ++j) {
+		u[j] = static_cast<T>(0.25*(j + 1));
+		a[j] = static_cast<T>(0.25);
+	}
+
+	// par spreads from a known hazard curve
+	T th[] = {1, 3, 5};
+	T h[] = {static_cast<T>(0.01), static_cast<T>(0.02), static_cast<T>(0.015)};
+	hazard_curve<T> H(3, th, h, h[2]);
+	T s[3];
+	for (int i = 0; i < 3; ++i) {
+		size_t m = static_cast<size_t>(4*th[i]);
+		T prot = credit_default_swap<T>(m, u, a, 0, R, F, H);
+		T prem = prot - credit_default_swap<T>(m, u, a, 1, R, F, H);
+		s[i] = prot/prem;
+	}
+
+	credit_curve<T> cc(F, R);
+	for (int i = 0; i < 3; ++i)
+		cc.add(static_cast<size_t>(4*th[i]), u, a, s[i]);
+
+	hazard_curve<T> H_ = cc.hazard_curve();
+	ensure (H_.n == 3);
+	for (size_t i = 0; i < H_.n; ++i) {
+		ensure (H_.t[i] == th[i]);
+		ensure (fabs(H_.f[i] - h[i]) < eps);
+	}
+	ensure (H_._f == H_.f[2]);
+
+	// repriced at par
+	for (int i = 0; i < 3; ++i)
+		ensure (fabs(credit_default_swap<T>(static_cast<size_t>(4*th[i]), u, a, s[i], R, F, H_)) < eps);
+
+	// upfront quote with a standard coupon
+	T c = static_cast<T>(0.01);
+	T p = credit_default_swap<T>(20, u, a, c, R, F, H);
+	cc.reset();
+	cc.add(20, u, a, c, p);
+	ensure (fabs(credit_default_swap<T>(20, u, a, c, R, F, cc.hazard_curve(), p)) < eps);
+
+	// stack scratch agrees with the curve's
+	T h0 = bootstrap_hazard<T>(12, u, a, s[1], R, F, 1, th, h);
+	T w[24];
+	ensure (bootstrap_hazard<T>(12, u, a, s[1], R, F, 1, th, h, 0, 0, w) == h0);
+	ensure (fabs(h0 - h[1]) < eps);
+}
+
+void
+fms_test_credit_curve(void)
+{
+	test_credit_curve<double>();
+	test_credit_curve<float>();
+}
@@ -0,0 +1,118 @@
+// tcurve_graph.cpp - test concurrent curve building
+#include <atomic>
+#include <cmath>
+#include <vector>
+#include "../ensure.h"
+#include "../curve_graph.h"
+
+using namespace pwflat;
+
+static std::atomic<int> builds(0);
+
+// par swaps with annual coupons e = exp(f) - 1 bootstrap to constant f
+static void
+build_flat(yield_curve<>& yc, double f)
+{
+	double e = exp(f) - 1;
+	double t[10], c[10];
+
+	++builds;
+	t[0] = 0;
+	c[0] = 0;
+	for (int i = 1; i < 10; ++i) {
+		c[i - 1] -= 1;
+		t[i] = i;
+		c[i] = 1 + e;
+		yc.add(i + 1, t, c);
+	}
+}
+
+void
+test_curve_graph(size_t threads)
+{
+	curve_graph<> g;
+	double f0 = 0.03;
+
+	size_t ois = g.add([&f0](yield_curve<>& yc, const curve_graph<>&) { build_flat(yc, f0); });
+	size_t other = g.add([](yield_curve<>& yc, const curve_graph<>&) { build_flat(yc, 0.05); });
+	// basis curve is ois plus 10bp
+	size_t dep[] = {ois};
+	size_t basis = g.add([ois](yield_curve<>& yc, const curve_graph<>& g) {
+		++builds;
+		auto f = g.forward_curve(ois);
+		double t[] = {0, f.t[f.n - 1]};
+		double c[] = {-1, 1/(discount(t[1], f)*exp(-0.001*t[1]))};
+		yc.add(2, t, c);
+	}, 1, dep);
+	size_t dep2[] = {ois, basis};
+	size_t spread = g.add([ois,basis](yield_curve<>& yc, const curve_graph<>& g) {
+		++builds;
+		double t[] = {0, 1};
+		double c[] = {-1, discount(1., g.forward_curve(ois))/discount(1., g.forward_curve(basis))};
+		yc.add(2, t, c);
+	}, 2, dep2);
+
+	builds = 0;
+	ensure (g.build(threads) == 4);
+	ensure (builds == 4);
+	ensure (!g.dirty(spread));
+
+	auto f = g.forward_curve(basis);
+	ensure (fabs(f.f[0] - (f0 + 0.001)) < 1e-12);
+	ensure (fabs(g.forward_curve(spread).f[0] - 0.001) < 1e-12);
+	ensure (fabs(g.forward_curve(other).f[3] - 0.05) < 1e-12);
+
+	// nothing changed
+	builds = 0;
+	ensure (g.build(threads) == 0);
+	ensure (builds == 0);
+
+	// only ois and its dependents are rebuilt
+	f0 = 0.02;
+	builds = 0;
+	ensure (g.touch(ois).build(threads) == 3);
+	ensure (builds == 3);
+	ensure (fabs(g.forward_curve(basis).f[0] - (f0 + 0.001)) < 1e-12);
+
+	builds = 0;
+	ensure (g.touch(basis).build(threads) == 2);
+	ensure (builds == 2);
+
+	// failures propagate and leave the curve dirty
+	curve_graph<> h;
+	size_t bad = h.add([](yield_curve<>&, const curve_graph<>&) { throw std::runtime_error("bad"); });
+	size_t dep3[] = {bad};
+	h.add([](yield_curve<>&, const curve_graph<>&) { }, 1, dep3);
+	bool thrown = false;
+	try {
+		h.build(threads);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	ensure (thrown);
+	ensure (h.dirty(bad));
+
+	// jump dates and spreads are not added twice when a curve is rebuilt
+	curve_graph<> k;
+	size_t turn = k.add([](yield_curve<>& yc, const curve_graph<>&) {
+		yc.add_jump(0.5).add_spread(0.75, 1.25, 0.01);
+		build_flat(yc, 0.03);
+	});
+	ensure (k.build(threads) == 1);
+	auto f1 = k.forward_curve(turn);
+	std::vector<double> t1(f1.t, f1.t + f1.n), ff1(f1.f, f1.f + f1.n);
+	ensure (k.touch(turn).build(threads) == 1);
+	auto f2 = k.forward_curve(turn);
+	ensure (f2.n == t1.size());
+	for (size_t j = 0; j < f2.n; ++j)
+		ensure (f2.t[j] == t1[j] && f2.f[j] == ff1[j]);
+	ensure (fabs(discount(1., f2) - exp(-0.03)) < 1e-12);
+}
+
+void
+fms_test_curve_graph(void)
+{
+	test_curve_graph(1);
+	test_curve_graph(4);
+}
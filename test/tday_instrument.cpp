@@ -0,0 +1,52 @@
+// tday_instrument.cpp - test cash flows on integer days
+#include <cmath>
+#include "../ensure.h"
+#include "../day_instrument.h"
+#include "../interest_rate_swap.h"
+
+using namespace fixed_income;
+using namespace pwflat;
+
+void
+test_day_instrument(void)
+{
+	double t[] = {0.5, 1, 2, 5, 10};
+	double f[] = {0.01, 0.02, 0.025, 0.03, 0.035};
+	forward_curve<> fc(5, t, f);
+
+	date val(2012, 11, 11);
+	date eff(date(val).incr(2, datetime::UNIT_DAYS));
+	interest_rate_swap<> irs(eff, 5, datetime::UNIT_YEARS, datetime::FREQ_SEMIANNUALLY, datetime::DCB_30U_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+	irs.fix(val, 0.04);
+
+	day_cash_flows<> dcf(irs, val);
+	ensure (dcf.n == irs.n);
+	ensure (dcf.d[0] == epoch_day(eff));
+	ensure (epoch_day(date(1970, 1, 2)) == 1);
+
+	int v = epoch_day(val);
+	ensure (fabs(present_value(dcf, v, fc) - present_value<double>(irs.n, irs.t, irs.c, fc.n, fc.t, fc.f)) < 1e-14);
+	ensure (fabs(duration(dcf, v, fc, v) - duration<double>(irs.n, irs.t, irs.c, fc.n, fc.t, fc.f)) < 1e-13);
+	ensure (fabs(duration(dcf, v, fc, v + 365) - duration<double>(irs.n, irs.t, irs.c, fc.n, fc.t, fc.f, 0, 365/365.25)) < 1e-13);
+
+	// moving the valuation date is the same as refixing
+	for (int k = 1; k < 40; k += 7) {
+		date val_(date(val).incr(k, datetime::UNIT_DAYS));
+		irs.fix(val_, 0.04);
+		double pv = present_value<double>(irs.n, irs.t, irs.c, fc.n, fc.t, fc.f);
+		if (k > 2) // settlement flow is in the past
+			pv -= irs.c[0]*discount(irs.t[0], fc);
+		ensure (fabs(present_value(dcf, v + k, fc) - pv) < 1e-14);
+	}
+
+	// table lookup
+	discount_cache<> D(3653);
+	D.bind(fc, 1);
+	ensure (fabs(present_value(dcf, v, D) - present_value(dcf, v, fc)) < 1e-14);
+}
+
+void
+fms_test_day_instrument(void)
+{
+	test_day_instrument();
+}
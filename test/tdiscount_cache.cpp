@@ -0,0 +1,91 @@
+// tdiscount_cache.cpp - test memoized discount factors
+#include <cmath>
+#include <thread>
+#include <vector>
+#include "../ensure.h"
+#include "../discount_cache.h"
+#include "../curve_graph.h"
+
+using namespace pwflat;
+
+void
+test_discount_cache(void)
+{
+	double t[] = {0.5, 1, 2, 5, 10};
+	double f[] = {0.01, 0.02, 0.025, 0.03, 0.035};
+	forward_curve<> fc(5, t, f);
+
+	discount_cache<> D(3653);
+	D.bind(fc, 1);
+	ensure (D.epoch() == 1);
+
+	// lazy and bulk give the curve discount exactly
+	for (int d = 0; d < 4000; d += 7)
+		ensure (D(d) == discount(d/365.25, fc));
+	D.fill();
+	for (int d = 0; d < 3653; ++d)
+		ensure (D(d) == discount(d/365.25, fc));
+
+	int day[] = {0, 182, 365, 730};
+	double c[] = {-1, 0.02, 0.02, 1.02};
+	double pv = 0;
+	for (int j = 0; j < 4; ++j)
+		pv += c[j]*discount(day[j]/365.25, fc);
+	ensure (D.present_value(4, day, c) == pv);
+
+	// new epoch invalidates
+	double g[] = {0.05, 0.05, 0.05, 0.05, 0.05};
+	D.bind(forward_curve<>(5, t, g), 2);
+	ensure (fabs(D(365) - exp(-0.05*365/365.25)) < 1e-15);
+
+	// concurrent readers
+	D.bind(fc, 3);
+	std::vector<std::thread> pool;
+	std::vector<int> bad(4, 0);
+	for (int k = 0; k < 4; ++k)
+		pool.push_back(std::thread([&D,&fc,&bad,k]() {
+			for (int d = 0; d < 3653; ++d)
+				bad[k] += D(d) != discount(d/365.25, fc);
+		}));
+	for (auto& th : pool)
+		th.join();
+	for (int k = 0; k < 4; ++k)
+		ensure (bad[k] == 0);
+}
+
+void
+test_discount_cache_epoch(void)
+{
+	curve_graph<> g;
+	double r = 0.02;
+	size_t i = g.add([&r](yield_curve<>& yc, const curve_graph<>&) { yc.add(1., exp(r)).add(2., exp(2*r)); });
+	ensure (g.epoch(i) == 0);
+	g.build(1);
+	ensure (g.epoch(i) == 1);
+
+	discount_cache<> D(1000);
+	D.bind(g.forward_curve(i), g.epoch(i));
+	ensure (fabs(D(365) - exp(-r*365/365.25)) < 1e-15);
+
+	ensure (D.cached(365) && !D.cached(366));
+
+	// same epoch keeps cached values
+	double D365 = D(365);
+	D.bind(g.forward_curve(i), g.epoch(i));
+	ensure (D.cached(365) && !D.cached(366));
+	ensure (D(365) == D365);
+
+	r = 0.03;
+	g.touch(i).build(1);
+	ensure (g.epoch(i) == 2);
+	D.bind(g.forward_curve(i), g.epoch(i));
+	ensure (!D.cached(365));
+	ensure (fabs(D(365) - exp(-r*365/365.25)) < 1e-15);
+}
+
+void
+fms_test_discount_cache(void)
+{
+	test_discount_cache();
+	test_discount_cache_epoch();
+}
@@ -0,0 +1,44 @@
+// tensure.cpp - check levels and the status path
+#include <stdexcept>
+#include "../ensure.h"
+
+static bool positive(double x, ensure_failure* s)
+{
+	return ensure_status(x > 0, s) && ensure_status(x < 1, s);
+}
+
+void
+fms_test_ensure(void)
+{
+	{
+		ensure_failure s = {0, 0, 0};
+		ensure (positive(0.5, &s));
+		ensure (s.file == 0);
+		ensure (!positive(-1, &s));
+		ensure (s.file != 0 && s.line > 0);
+		const char* expr = s.expr;
+		ensure (!positive(2, &s)); // only the first failure is kept
+		ensure (s.expr == expr);
+		ensure (!positive(-1, 0)); // null status
+	}
+	{
+		bool thrown = false;
+		try {
+			ensure (1 == 0);
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		ensure (thrown == (ENSURE_LEVEL > 0));
+	}
+	{
+		bool thrown = false;
+		try {
+			ensure_debug (1 == 0);
+		}
+		catch (const std::runtime_error&) {
+			thrown = true;
+		}
+		ensure (thrown == (ENSURE_LEVEL > 1));
+	}
+}
@@ -0,0 +1,49 @@
+// texposure.cpp - test exposure grids
+#include <cmath>
+#include <vector>
+#include "../ensure.h"
+#include "../exposure.h"
+
+using namespace pwflat;
+
+void
+test_exposure(void)
+{
+	double t[] = {1, 2, 3};
+	double f[] = {0.01, 0.02, 0.03};
+	forward_curve<> F(3, t, f, 0.04);
+
+	double u0[] = {0, 0.5, 1, 1.5, 2};
+	double c0[] = {-1, 0.01, 0.01, 0.01, 1.01};
+	double u1[] = {0.25, 2.5, 4};
+	double c1[] = {-1, 0.05, 1.05};
+	double u2[] = {3.5};
+	double c2[] = {1};
+	fixed_income::instrument<> i[] = {
+		fixed_income::instrument<>(5, u0, c0),
+		fixed_income::instrument<>(3, u1, c1),
+		fixed_income::instrument<>(1, u2, c2)
+	};
+
+	double s[] = {0, 0.25, 0.7, 1, 2, 3, 5};
+	const size_t ns = sizeof(s)/sizeof(*s), ni = sizeof(i)/sizeof(*i);
+	std::vector<double> v(ns*ni);
+
+	exposure(ns, s, ni, i, F, &v[0], 2);
+
+	for (size_t k = 0; k < ns; ++k) {
+		for (size_t l = 0; l < ni; ++l) {
+			double pv(0);
+			for (size_t j = 0; j < i[l].n; ++j)
+				if (i[l].t[j] > s[k])
+					pv += i[l].c[j]*discount(i[l].t[j], F)/discount(s[k], F);
+			ensure (fabs(v[k*ni + l] - pv) < 1e-15);
+		}
+	}
+}
+
+void
+fms_test_exposure(void)
+{
+	test_exposure();
+}
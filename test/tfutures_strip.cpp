@@ -0,0 +1,129 @@
+// tfutures_strip.cpp - test futures strip bootstrap
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "../ensure.h"
+#include "../eurodollar_futures.h"
+#include "../pwflat_yield_curve.h"
+
+using namespace fixed_income;
+using namespace pwflat;
+
+void
+test_eurodollar_effective(void)
+{
+	date set(2011, 9, 1);
+	date eff = eurodollar_effective(set, 1);
+	ensure (eff.year() == 2011 && eff.month() == 9 && eff.day() == 21);
+	eff = eurodollar_effective(set, 2);
+	ensure (eff.year() == 2011 && eff.month() == 12 && eff.day() == 21);
+
+	// September contract stops trading 2 business days before
+	eff = eurodollar_effective(date(2011, 9, 20), 1);
+	ensure (eff.month() == 12 && eff.wday() == datetime::DAY_WED);
+	eff = eurodollar_effective(date(2011, 11, 30), 5);
+	ensure (eff.year() == 2012 && eff.month() == 12 && eff.day() == 19);
+}
+
+void
+test_futures_convexity(void)
+{
+	ensure (fabs(futures_rate(97.5) - 0.025) < 1e-15);
+	ensure (futures_convexity(1., 1.25, 0.1, 0.) == 0);
+
+	// Ho-Lee limit
+	double c0 = futures_convexity(1., 1.25, 0., 0.01);
+	ensure (fabs(c0 - 0.0001*1*1.25/2) < 1e-15);
+	ensure (fabs(futures_convexity(1., 1.25, 1e-6, 0.01) - c0) < 1e-9);
+
+	// mean reversion reduces the adjustment, which grows with expiration
+	ensure (futures_convexity(1., 1.25, 0.1, 0.01) < c0);
+	ensure (futures_convexity(2., 2.25, 0.1, 0.01) > futures_convexity(1., 1.25, 0.1, 0.01));
+}
+
+void
+test_bootstrap_strip(void)
+{
+	// overlap, adjacent, overlap, underlap
+	double u0[] = {0.1, 0.25, 0.4, 1.0};
+	double u1[] = {0.35, 0.5, 0.65, 1.25};
+	double d[] = {1.01, 1.0105, 1.011, 1.012};
+	size_t m = sizeof(u0)/sizeof(*u0);
+
+	std::vector<double> t(1 + m), f(1 + m);
+	t[0] = 0.25;
+	f[0] = bootstrap1(0.25, 1.0098, forward_curve<>());
+
+	ensure (bootstrap_strip(m, u0, u1, d, 1, &t[0], &f[0]) == 1 + m);
+
+	forward_curve<> fc(1 + m, &t[0], &f[0]);
+	for (size_t k = 0; k < m; ++k) {
+		ensure (t[1 + k] == u1[k]);
+		ensure (fabs(discount(u0[k], fc)/discount(u1[k], fc) - d[k]) < 1e-14);
+		// same as instrument by instrument
+		double fk = bootstrap2(u0[k], -1., u1[k], d[k], forward_curve<>(1 + k, &t[0], &f[0]));
+		ensure (fabs(fk - f[1 + k]) < 1e-14);
+	}
+
+	// periods out of order are rejected before anything is written
+	std::vector<double> t2(t), f2(f);
+	double w0[] = {0.1, 0.4, 0.25}, w1[] = {0.35, 0.65, 0.5};
+	bool thrown = false;
+	try {
+		bootstrap_strip(3, w0, w1, d, 1, &t2[0], &f2[0]);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	ensure (thrown && t2 == t && f2 == f);
+}
+
+void
+test_eurodollar_strip(void)
+{
+	date set(2012, 11, 11);
+	double price[] = {99.69, 99.68, 99.66, 99.63, 99.58, 99.52, 99.45, 99.37};
+	size_t m = sizeof(price)/sizeof(*price);
+	std::vector<double> u0(m), u1(m), d(m);
+
+	eurodollar_strip(set, m, price, &u0[0], &u1[0], &d[0], 0.03, 0.01);
+
+	yield_curve<> yc;
+	yc.add(u0[0], 1 + futures_rate(price[0])*u0[0]);
+	yc.add_strip(m, &u0[0], &u1[0], &d[0]);
+	ensure (yc.size() == 1 + m);
+
+	// a bad contract leaves the curve as it was
+	double v0[] = {u1[m-1], u1[m-1] + 0.25}, v1[] = {u1[m-1] + 0.25, u1[m-1] + 0.5}, e[] = {1.01, -1};
+	bool thrown = false;
+	try {
+		yc.add_strip(2, v0, v1, e);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	ensure (thrown && yc.size() == 1 + m && yc.maturity() == u1[m-1]);
+	ensure (yc.forward_curve().n == 1 + m);
+
+	auto fc = yc.forward_curve();
+	for (size_t k = 0; k < m; ++k) {
+		eurodollar_futures<> edf(static_cast<unsigned int>(k + 1), 0.03, 0.01);
+		edf.fix(set, price[k]);
+		ensure (fabs(present_value(edf.n, edf.t, edf.c, fc.n, fc.t, fc.f)) < 1e-14);
+
+		// convexity lowers the forward rate
+		eurodollar_futures<> edf0(static_cast<unsigned int>(k + 1));
+		edf0.fix(set, price[k]);
+		ensure (edf0.t[1] == edf.t[1]);
+		ensure (edf.c[1] < edf0.c[1]);
+	}
+}
+
+void
+fms_test_futures_strip(void)
+{
+	test_eurodollar_effective();
+	test_futures_convexity();
+	test_bootstrap_strip();
+	test_eurodollar_strip();
+}
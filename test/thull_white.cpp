@@ -0,0 +1,76 @@
+// thull_white.cpp - test Hull-White Monte Carlo
+#include <cmath>
+#include <vector>
+#include "../ensure.h"
+#include "../hull_white.h"
+
+using namespace pwflat;
+
+void
+test_hull_white(void)
+{
+	double t[] = {1, 2, 5};
+	double f[] = {0.01, 0.02, 0.03};
+	forward_curve<> F(3, t, f, 0.03);
+	hull_white<> hw(F, 0.1, 0.01);
+
+	// fits the initial curve
+	for (double u = 0; u < 10; u += 0.5)
+		ensure (fabs(hw.zero(0, u, 0) - discount(u, F)) < 1e-15);
+
+	const size_t k = 8, np = 20000;
+	double s[k] = {0.25, 0.5, 1, 1.5, 2, 3, 4, 5};
+	std::vector<double> x(k*np), y(k*np), x_(k*np), y_(k*np);
+
+	// reproducible for any number of threads
+	hw.simulate(k, s, np, &x[0], &y[0], 123, 1);
+	hw.simulate(k, s, np, &x_[0], &y_[0], 123, 3);
+	ensure (x == x_);
+	ensure (y == y_);
+
+	// E[D(s)] = P(0, s) and E[D(s) P(s, 6)] = P(0, 6)
+	for (size_t d = 0; d < k; ++d) {
+		double D(0), DD(0), DP(0), DPDP(0);
+		for (size_t p = 0; p < np; ++p) {
+			double Dp = hw.numeraire(s[d], y[d*np + p]);
+			double DPp = Dp*hw.zero(s[d], 6, x[d*np + p]);
+			D += Dp;
+			DD += Dp*Dp;
+			DP += DPp;
+			DPDP += DPp*DPp;
+		}
+		D /= np;
+		DP /= np;
+		ensure (fabs(D - discount(s[d], F)) < 4*sqrt((DD/np - D*D)/np));
+		ensure (fabs(DP - discount(6., F)) < 4*sqrt((DPDP/np - DP*DP)/np));
+	}
+
+	// pathwise swap values are martingales when discounted
+	double e = exp(0.02) - 1;
+	double u[] = {0, 1, 2, 3, 4, 5};
+	double c[] = {-1, e, e, e, e, 1 + e};
+	fixed_income::instrument<> i(6, u, c);
+	std::vector<double> v(k*np);
+	hw.value(i, k, s, np, &x[0], &v[0], 2);
+	for (size_t d = 0; d < k; ++d) {
+		double pv(0), pv0(0);
+		for (size_t p = 0; p < np; ++p)
+			pv += hw.numeraire(s[d], y[d*np + p])*v[d*np + p];
+		pv /= np;
+		for (size_t j = 0; j < 6; ++j)
+			if (u[j] > s[d])
+				pv0 += c[j]*discount(u[j], F);
+		ensure (fabs(pv - pv0) < 1e-3);
+	}
+
+	std::vector<double> epe(k);
+	hw.exposure(k, s, np, &y[0], &v[0], &epe[0]);
+	for (size_t d = 0; d < k; ++d)
+		ensure (epe[d] >= 0);
+}
+
+void
+fms_test_hull_white(void)
+{
+	test_hull_white();
+}
@@ -1,8 +1,4 @@
 // tinstrument.cpp - test instrument classes
-#ifndef ensure
-#include <cassert>
-#define ensure(x) assert(x)
-#endif
 #include "../bootstrap.h"
 
 using namespace fixed_income;
@@ -0,0 +1,160 @@
+// tintegral_grid.cpp - test batch integral kernels against the curve and the scalar reference
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <limits>
+#include <random>
+#include <vector>
+#include "../ensure.h"
+#include "../cpu_dispatch.h"
+#include "../integral_grid.h"
+#include "../pwflat.h"
+
+using namespace pwflat;
+
+template<class T>
+void
+test_integral_grid(simd_level level)
+{
+	std::default_random_engine e;
+	std::uniform_real_distribution<T> dt(static_cast<T>(0.01), 1), df(0, static_cast<T>(0.05));
+	T eps = std::numeric_limits<T>::epsilon();
+
+	for (size_t n = 0; n < 40; n += 1 + n/4) {
+		std::vector<T> t(n), f(n);
+		T s(0);
+		for (size_t i = 0; i < n; ++i) {
+			s += dt(e);
+			t[i] = s;
+			f[i] = df(e);
+		}
+		forward_curve<T> fc(n, t.data(), f.data(), static_cast<T>(0.03));
+		integral_grid<T> g(n, t.data(), f.data(), static_cast<T>(0.03), level);
+		ensure (g.grid());
+
+		// knots, near knots, random and past the end, not a multiple of the lane count
+		std::vector<T> u;
+		for (size_t i = 0; i < n; ++i) {
+			u.push_back(t[i]);
+			u.push_back(std::nextafter(t[i], T(0)));
+			u.push_back(std::nextafter(t[i], T(100)));
+		}
+		for (size_t j = 0; j < 37; ++j)
+			u.push_back((s + 2)*j/36);
+		u.push_back(-1);
+
+		std::vector<T> I(u.size());
+		g.integral(u.size(), u.data(), I.data());
+		for (size_t j = 0; j < u.size(); ++j) {
+			T I_ = fc.integral(u[j]);
+			ensure (fabs(I[j] - I_) <= 4*eps*(1 + fabs(I_)));
+		}
+	}
+}
+
+template<class T>
+void
+test_integral_grid_fallback(void)
+{
+	// knots too close for the bucket limit use binary search
+	T t[] = {1, static_cast<T>(1.001), 2, 5};
+	T f[] = {static_cast<T>(0.01), static_cast<T>(0.02), static_cast<T>(0.03), static_cast<T>(0.04)};
+	forward_curve<T> fc(4, t, f, static_cast<T>(0.05));
+	integral_grid<T> g(4, t, f, static_cast<T>(0.05), simd_support(), 64);
+	ensure (!g.grid());
+	integral_grid<T> h(4, t, f, static_cast<T>(0.05));
+	ensure (h.grid());
+
+	for (T u = -1; u < 7; u += static_cast<T>(0.0625)) {
+		ensure (g.integral(u) == fc.integral(u));
+		ensure (fabs(h.integral(u) - fc.integral(u)) <= 4*std::numeric_limits<T>::epsilon()*(1 + fabs(fc.integral(u))));
+	}
+}
+
+// every kernel against the scalar reference on the same grid
+template<class T>
+void
+test_integral_grid_dispatch(void)
+{
+	std::default_random_engine e;
+	std::uniform_real_distribution<T> dt(static_cast<T>(0.001), static_cast<T>(0.5)), df(static_cast<T>(-0.01), static_cast<T>(0.08));
+	T eps = std::numeric_limits<T>::epsilon();
+
+	size_t n = 500;
+	std::vector<T> t(n), f(n);
+	T s(0);
+	for (size_t i = 0; i < n; ++i) {
+		s += dt(e);
+		t[i] = s;
+		f[i] = df(e);
+	}
+	std::uniform_real_distribution<T> du(-1, s + 1);
+	std::vector<T> u(1001), c(u.size());
+	for (size_t j = 0; j < u.size(); ++j) {
+		u[j] = du(e);
+		c[j] = static_cast<T>(0.01);
+	}
+
+	integral_grid<T> ref(n, t.data(), f.data(), static_cast<T>(0.03), SIMD_SCALAR);
+	std::vector<T> I(u.size()), J(u.size());
+	integral_grid_scalar(ref.view(), u.size(), u.data(), I.data());
+
+	for (int level = SIMD_SCALAR; level <= simd_support(); ++level) {
+		integral_grid<T> g(n, t.data(), f.data(), static_cast<T>(0.03), static_cast<simd_level>(level));
+		ensure (g.level() == level);
+
+		integral_grid_kernel<T>::select(g.level())(g.view(), u.size(), u.data(), J.data());
+		for (size_t j = 0; j < u.size(); ++j)
+			ensure (fabs(I[j] - J[j]) <= 2*eps*(1 + fabs(I[j])));
+
+		g.discount(u.size(), u.data(), J.data());
+		for (size_t j = 0; j < u.size(); ++j)
+			ensure (fabs(exp(-I[j]) - J[j]) <= 4*eps*(1 + fabs(J[j])));
+
+		T pv(0);
+		for (size_t j = 0; j < u.size(); ++j)
+			pv += c[j]*exp(-I[j]);
+		ensure (fabs(g.present_value(u.size(), u.data(), c.data()) - pv) <= 64*eps*pv);
+	}
+}
+
+void
+test_simd_select(void)
+{
+	simd_level best = simd_support();
+
+	ensure (simd_parse("scalar") == SIMD_SCALAR);
+	ensure (simd_parse("avx512", SIMD_AVX2) == SIMD_AVX2);
+	ensure (simd_parse("avx2", SIMD_AVX512) == SIMD_AVX2);
+	ensure (simd_parse("sse9") == best);
+	ensure (simd_parse(0) == best);
+	ensure (simd_selected() <= best);
+
+	simd_level prev = simd_select(SIMD_SCALAR);
+	double t[] = {1, 2}, f[] = {0.01, 0.02};
+	ensure (integral_grid<>(2, t, f).level() == SIMD_SCALAR);
+	ensure (simd_select(prev) == SIMD_SCALAR);
+	ensure (simd_selected() == prev);
+
+	// the default does not depend on timing
+	if (!getenv("PWFLAT_SIMD"))
+		ensure (simd_selected() == std::min(best, SIMD_AVX2));
+	ensure (strcmp(simd_name(SIMD_AVX2), "avx2") == 0);
+}
+
+void
+fms_test_integral_grid(void)
+{
+	simd_level best = simd_support();
+
+	for (int level = SIMD_SCALAR; level <= best; ++level) {
+		test_integral_grid<double>(static_cast<simd_level>(level));
+		test_integral_grid<float>(static_cast<simd_level>(level));
+	}
+	test_integral_grid_fallback<double>();
+	test_integral_grid_fallback<float>();
+	test_integral_grid_dispatch<double>();
+	test_integral_grid_dispatch<float>();
+	test_simd_select();
+}
@@ -0,0 +1,98 @@
+// tknot_index.cpp - test Eytzinger knot search
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <vector>
+#include "../ensure.h"
+#include "../pwflat.h"
+
+using namespace pwflat;
+
+void
+test_knot_index_search(void)
+{
+	for (size_t n = 0; n < 70; ++n) {
+		std::vector<double> t(n), f(n);
+		for (size_t i = 0; i < n; ++i) {
+			t[i] = 0.25*(i + 1);
+			f[i] = 0.01 + 0.001*i;
+		}
+		knot_index<> ki(n, t.data(), f.data());
+		ensure (ki.size() == n);
+
+		// knots, midpoints and both ends
+		for (double u = -0.125; u <= 0.25*n + 0.5; u += 0.125) {
+			ensure (ki.lower_bound(u) == static_cast<size_t>(std::lower_bound(t.begin(), t.end(), u) - t.begin()));
+			ensure (ki.upper_bound(u) == static_cast<size_t>(std::upper_bound(t.begin(), t.end(), u) - t.begin()));
+		}
+	}
+}
+
+void
+test_knot_index_curve(void)
+{
+	size_t n = 1000;
+	std::vector<double> t(n), f(n);
+	for (size_t i = 0; i < n; ++i) {
+		t[i] = (i + 1)/365.;
+		f[i] = 0.02 + 0.01*sin(i/50.);
+	}
+
+	forward_curve<> fc(n, t.data(), f.data(), 0.03);
+	knot_index<> ki(n, t.data(), f.data());
+	forward_curve<> fi(fc);
+	fi.set_index(&ki);
+
+	// same answers with and without the index
+	for (double u = -0.01; u < 3; u += 0.0007) {
+		ensure (fi(u) == fc(u));
+		ensure (fi.integral(u) == fc.integral(u));
+		ensure (discount(u, fi) == discount(u, fc));
+		ensure (spot(u, fi) == spot(u, fc));
+	}
+	for (size_t i = 0; i < n; ++i) {
+		ensure (fi(t[i]) == f[i]);
+		ensure (fi.integral(t[i]) == fc.integral(t[i]));
+	}
+
+	// pricing goes through the index
+	std::vector<double> u(40), c(40, 0.01);
+	for (size_t j = 0; j < u.size(); ++j)
+		u[j] = 0.07*(j + 1);
+	c.back() += 1;
+	fixed_income::instrument<> i(u.size(), u.data(), c.data());
+	ensure (present_value(i, fi) == present_value(i, fc));
+	std::vector<double> f1(f);
+	for (size_t k = 0; k < n; ++k)
+		f1[k] += 0.01;
+	knot_index<> k1(n, t.data(), f1.data());
+	forward_curve<> fc1(n, t.data(), f1.data(), 0.03);
+	forward_curve<> fi1(fc1);
+	fi1.set_index(&k1);
+	ensure (present_value(i, fi1) == present_value(i, fc1));
+	ensure (duration(i, fi1) == duration(i, fc1));
+	ensure (present_value(i, fi1) < present_value(i, fi));
+
+	// an index from other forwards is rejected
+	ensure (k1.matches(n, t.data(), f1.data()) && !k1.matches(n, t.data(), f.data()));
+#if ENSURE_LEVEL > 1
+	bool thrown = false;
+	try {
+		forward_curve<>(fc).set_index(&k1);
+	}
+	catch (const std::runtime_error&) {
+		thrown = true;
+	}
+	ensure (thrown);
+#endif
+
+	fi.set(n, t.data(), f.data());
+	ensure (fi.index == 0);
+}
+
+void
+fms_test_knot_index(void)
+{
+	test_knot_index_search();
+	test_knot_index_curve();
+}
@@ -3,6 +3,7 @@
 #include <iostream>
 #include <functional>
 #include <random>
+#include <utility>
 #include "../ensure.h"
 #include "../newton.h"
 
@@ -13,9 +14,37 @@ static std::uniform_real_distribution<> urd(0, 1);
 static auto u = std::bind(urd, eng);
 static double eps = numeric_limits<double>::epsilon();
 
+// stop once f is at rounding noise instead of cycling between two iterates
+static void
+test_newton_noise(void)
+{
+	double d = 1e-10; // f jumps over its root at 0.5
+	auto f = [d](double x) { return x - 0.5 + (x > 0.5 ? d : -d); };
+	auto df = [](double) { return 1.; };
+
+	double r = root1d::newton(1., f, df);
+	ensure (fabs(r - 0.5) <= 2*d);
+}
+
+// plain Newton diverges for atan from |x| > 1.39
+static void
+test_newton_bracket(void)
+{
+	auto fdf = [](double x) { return make_pair(atan(x), 1/(1 + x*x)); };
+
+	ensure (std::isnan(root1d::newton_fdf(2., fdf, 100)));
+	size_t steps = 0;
+	double r = root1d::newton_bracket(2., fdf, -1., 3., 200, &steps);
+	ensure (fabs(r) <= eps && steps > 0 && steps < 200);
+	ensure (root1d::newton_bracket(2., fdf, 1., 3.) != root1d::newton_bracket(2., fdf, 1., 3.)); // no bracket
+}
+
 void
 fms_test_newton(void)
 {
+	test_newton_noise();
+	test_newton_bracket();
+
 	for (int i = 0; i < 10000; ++i) {
 		double a = u();
 		double b = u();
@@ -36,5 +65,9 @@ fms_test_newton(void)
 //		cout << c - r << endl;
 		ensure (fabs(c - r)*a*(c - b) <= eps);
 
+		// fused value and derivative agrees with separate calls
+		auto fdf = [f,df](double x) { return make_pair(f(x), df(x)); };
+		ensure (root1d::newton_fdf((b + c)/3, fdf) == root1d::newton((b + c)/3, f, df));
+		ensure (root1d::newton_fdf((b + c)/1.5, fdf) == root1d::newton((b + c)/1.5, f, df));
 	}
 }
\ No newline at end of file
@@ -1,5 +1,6 @@
 // tpwflat.cpp - test the piecewise flat forward model
 // Copyright (c) 2011 KALX, LLC. All rights reserved. No warranty made.
+#include <cstring>
 #include "../pwflat_yield_curve.h"
 #include "../cash_deposit.h"
 #include "../forward_rate_agreement.h"
@@ -50,19 +51,19 @@ test_pwflat_yield_curve(void)
 	yc.reset();
 	date val(2012, 11, 11);
 
-	fixed_income::cash_deposit<> cd0(0, 1, UNIT_MONTH, DCB_ACTUAL_360, ROLL_MODIFIED_FOLLOWING);
+	fixed_income::cash_deposit<> cd0(0, 1, datetime::UNIT_MONTH, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING);
 	yc.add(cd0.fix(val, .01));
-	yc.add(fixed_income::cash_deposit<>(2, 2, UNIT_MONTH, DCB_ACTUAL_360, ROLL_MODIFIED_FOLLOWING).fix(val, 0.02));
+	yc.add(fixed_income::cash_deposit<>(2, 2, datetime::UNIT_MONTH, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING).fix(val, 0.02));
 
-	fixed_income::forward_rate_agreement<> fra0(date(val).incr(2,UNIT_MONTHS), 3, UNIT_MONTHS, DCB_ACTUAL_360, ROLL_MODIFIED_FOLLOWING);
+	fixed_income::forward_rate_agreement<> fra0(date(val).incr(2,datetime::UNIT_MONTHS), 3, datetime::UNIT_MONTHS, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING);
 	yc.add(fra0.fix(val, 0.03));
 
-	fixed_income::interest_rate_swap<> irs0(date(val).incr(2,UNIT_DAYS), 1, UNIT_YEAR, FREQ_SEMIANNUALLY, DCB_30U_360, ROLL_MODIFIED_FOLLOWING);
+	fixed_income::interest_rate_swap<> irs0(date(val).incr(2,datetime::UNIT_DAYS), 1, datetime::UNIT_YEAR, datetime::FREQ_SEMIANNUALLY, datetime::DCB_30U_360, datetime::ROLL_MODIFIED_FOLLOWING);
 	yc.add(irs0.fix(val, 0.04));
 
 	yield_curve<> yc1;
 	yc1.add(cd0)
-		.add(fixed_income::cash_deposit<>(2, 2, UNIT_MONTH, DCB_ACTUAL_360, ROLL_MODIFIED_FOLLOWING).fix(val, 0.02))
+		.add(fixed_income::cash_deposit<>(2, 2, datetime::UNIT_MONTH, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING).fix(val, 0.02))
 		.add(fra0)
 		.add(irs0);
 
@@ -73,17 +74,129 @@ test_pwflat_yield_curve(void)
 		ensure (fwd(t) == fwd1(t));
 
 }
+void
+test_pwflat_yield_curve_jump(void)
+{
+	double eps = 1e-14;
+
+	// meeting dates split the first segment and carry the forward
+	yield_curve<> yc;
+	yc.add_jump(0.5).add_jump(1.5);
+	yc.add(1., exp(0.04));
+	yc.add(2., exp(0.04 + 0.05));
+
+	auto fc = yc.forward_curve();
+	ensure (fc.n == 4);
+	ensure (fc.t[0] == 0.5 && fc.t[1] == 1 && fc.t[2] == 1.5 && fc.t[3] == 2);
+	ensure (fabs(fc.f[0] - 0.04) < eps && fabs(fc.f[1] - 0.04) < eps);
+	ensure (fabs(fc.f[2] - 0.04) < eps);
+	ensure (fabs(fc.f[3] - (0.09 - 0.06)/0.5) < eps);
+	ensure (fabs(exp(0.09)*discount(2., fc) - 1) < eps);
+
+	// strip with a jump inside a period
+	double u0[] = {1, 1.25, 1.5};
+	double u1[] = {1.25, 1.5, 1.75};
+	double d[] = {1.011, 1.012, 1.013};
+	yield_curve<> yc1;
+	yc1.add(1., exp(0.04)).add_jump(1.4);
+	yc1.add_strip(3, u0, u1, d);
+	fc = yc1.forward_curve();
+	ensure (fc.n == 5 && fc.t[3] == 1.5);
+	ensure (fc.f[2] == fc.f[1]);
+	for (int k = 0; k < 3; ++k)
+		ensure (fabs(discount(u0[k], fc)/discount(u1[k], fc) - d[k]) < eps);
+}
+
+void
+test_pwflat_yield_curve_spread(void)
+{
+	double eps = 1e-14;
+	double u0[] = {1, 1.25, 1.5};
+	double u1[] = {1.25, 1.5, 1.75};
+	double d[] = {1.011, 1.012, 1.013};
+
+	// turn of year spread straddling the first knot
+	yield_curve<> yc;
+	yc.add_spread(0.9, 1.1, 0.01).add_spread(1.0, 1.3, 0.02);
+	yc.add(1., exp(0.04));
+	yc.add_strip(3, u0, u1, d);
+	yc.add(0., -1., 2., exp(0.08));
+
+	auto fc = yc.forward_curve();
+	ensure (fabs(exp(0.04)*discount(1., fc) - 1) < eps);
+	ensure (fabs(exp(0.08)*discount(2., fc) - 1) < eps);
+	for (int k = 0; k < 3; ++k)
+		ensure (fabs(discount(u0[k], fc)/discount(u1[k], fc) - d[k]) < eps);
+
+	// overlay knots are merged into the curve
+	ensure (fabs(fc(0.95) - fc(0.85) - 0.01) < eps);
+	ensure (fabs(fc(1.05) - fc(1.15) - 0.01) < eps);
+	ensure (fabs(fc(1.2) - fc(1.05) + 0.01) < eps);
+	ensure (fabs(fc(1.35) - fc(1.3) + 0.02) < eps);
+
+	// same curve as pricing the shifted flows without overlays
+	yield_curve<> yc0;
+	yc0.add(1., exp(0.04));
+	ensure (fabs(yc0.forward_curve().integral(1.) - fc.integral(1.)) < eps);
+}
+
+void
+test_pwflat_yield_curve_try(void)
+{
+	double eps = 1e-14;
+	double f = 0.04, e = exp(f) - 1;
+	double u1[] = {1}, c1[] = {exp(f)};
+	double u2[] = {0, 1, 2}, c2[] = {-1, e, 1 + e};
+	double u3[] = {2, 3}, c3[] = {1, 1};
+
+	yield_curve<> yc;
+	yc.add_jump(0.5);
+	bootstrap_status<> s = yc.try_add(1, u1, c1);
+	ensure (s.converged && s.index == static_cast<size_t>(-1));
+	ensure (yc.size() == 2 && fabs(yc.forward_curve()(0.75) - f) < eps);
+
+	// failure leaves the curve as it was
+	yc.add_jump(1.5);
+	s = yc.try_add(2, u3, c3, 0., -1.);
+	ensure (!s.converged && s.index == 0);
+	ensure (yc.size() == 2 && yc.maturity() == 1);
+	s = yc.try_add(1, u1, c1);
+	ensure (!s.converged && s.check.file != 0 && yc.size() == 2);
+	ensure (strcmp(s.check.expr, "size() == 0 || tb[n-1] > maturity()") == 0);
+	s = yc.try_add(0, u3, c3);
+	ensure (!s.converged && strcmp(s.check.expr, "n != 0") == 0 && yc.size() == 2);
+
+	// in order until the first failure
+	fixed_income::instrument<> i[] = {
+		fixed_income::instrument<>(3, u2, c2),
+		fixed_income::instrument<>(2, u3, c3),
+	};
+	s = yc.try_add(2, i);
+	ensure (!s.converged && s.index == 1);
+	ensure (yc.size() == 4 && yc.maturity() == 2);
+	ensure (fabs(exp(2*f)*discount(2., yc.forward_curve()) - 1) < eps);
+
+	// reserved storage is not reallocated
+	yield_curve<> yr;
+	yr.reserve(8, 3).add_jump(0.5).add_spread(0.75, 1.25, 0.01);
+	s = yr.try_add(1, u1, c1);
+	ensure (s.converged);
+	const double* t0 = yr.forward_curve().t;
+	s = yr.try_add(3, u2, c2);
+	ensure (s.converged && yr.forward_curve().t == t0);
+}
+
 /*
 void
 test_eurodollar_first_contract(void)
 {
 	datetime::date imm(2011, 9, 1);
 		
-	imm.imm(3, DAY_WED);
+	imm.imm(3, datetime::DAY_WED);
 	ensure (imm.day() == 21);
 
 	datetime::date d(imm);
-	d.incr(-30, UNIT_DAYS);
+	d.incr(-30, datetime::UNIT_DAYS);
 
 	int ordinal;
 	ordinal = eurodollar_first_contract(d, 30);
@@ -97,5 +210,8 @@ void
 fms_test_pwflat(void)
 {
 	test_pwflat_yield_curve();
+	test_pwflat_yield_curve_jump();
+	test_pwflat_yield_curve_spread();
+	test_pwflat_yield_curve_try();
 //	test_eurodollar_first_contract();
 }
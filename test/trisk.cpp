@@ -0,0 +1,279 @@
+// trisk.cpp - test bucketed risk
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "../ensure.h"
+#include "../pwflat_risk.h"
+#include "../pwflat_yield_curve.h"
+
+using namespace fixed_income;
+using namespace pwflat;
+
+void
+test_knot_gradient(void)
+{
+	double t[] = {0.5, 1, 2, 5};
+	double f[] = {0.01, 0.02, 0.025, 0.03};
+	forward_curve<> fc(4, t, f, 0.035);
+
+	double u[] = {0.25, 1, 1.5, 3, 6};
+	double c[] = {0.1, 0.2, 0.3, 0.4, 1.1};
+	double g[4];
+	knot_gradient<> kg(fc);
+	kg.add(5, u, c).gradient(g);
+
+	// central difference
+	for (size_t i = 0; i < 4; ++i) {
+		double h = 1e-6;
+		double fp[4], fm[4];
+		std::copy(f, f + 4, fp);
+		std::copy(f, f + 4, fm);
+		fp[i] += h;
+		fm[i] -= h;
+		double dg = (present_value<double>(5, u, c, 4, t, fp, 0.035) - present_value<double>(5, u, c, 4, t, fm, 0.035))/(2*h);
+		ensure (fabs(g[i] - dg) < 1e-9);
+	}
+}
+
+// build the curve from deposits and annual swaps with rates r and optional prices p
+inline void
+build(yield_curve<>& yc, std::vector<std::vector<double>>& u, std::vector<std::vector<double>>& c,
+	const double* r, const double* p = 0)
+{
+	double mat[] = {0.5, 1, 2, 3, 5};
+
+	yc.reset();
+	u.assign(5, std::vector<double>());
+	c.assign(5, std::vector<double>());
+	for (size_t k = 0; k < 5; ++k) {
+		u[k].push_back(0);
+		c[k].push_back(-1);
+		if (k < 2) { // deposit
+			u[k].push_back(mat[k]);
+			c[k].push_back(1 + r[k]*mat[k]);
+		}
+		else {
+			for (size_t j = 1; j <= static_cast<size_t>(mat[k]); ++j) {
+				u[k].push_back(static_cast<double>(j));
+				c[k].push_back(r[k] + (j == mat[k]));
+			}
+		}
+		yc.add(u[k].size(), &u[k][0], &c[k][0], 0., p ? p[k] : 0.);
+	}
+}
+
+inline double
+portfolio_value(size_t ni, const instrument<>* i, const forward_curve<>& f)
+{
+	double pv = 0;
+
+	for (size_t l = 0; l < ni; ++l)
+		pv += present_value(i[l], f);
+
+	return pv;
+}
+
+void
+test_bucket_risk(void)
+{
+	double r[] = {0.01, 0.012, 0.015, 0.02, 0.025};
+	yield_curve<> yc;
+	std::vector<std::vector<double>> u, c;
+	build(yc, u, c, r);
+	auto fc = yc.forward_curve();
+
+	std::vector<instrument<>> ci;
+	for (size_t k = 0; k < 5; ++k)
+		ci.push_back(instrument<>(u[k].size(), &u[k][0], &c[k][0]));
+	bootstrap_jacobian<> J(5, &ci[0], fc);
+	for (size_t k = 0; k < 5; ++k)
+		for (size_t i = k + 1; i < 5; ++i)
+			ensure (J(k, i) == 0);
+
+	// portfolio: off grid swap and a zero past the curve
+	double pu0[] = {0.25, 1.25, 2.25, 3.25, 4.25};
+	double pc0[] = {-1, 0.03, 0.03, 0.03, 1.03};
+	double pu1[] = {7};
+	double pc1[] = {100};
+	std::vector<instrument<>> port;
+	port.push_back(instrument<>(5, pu0, pc0));
+	port.push_back(instrument<>(1, pu1, pc1));
+	for (int k = 0; k < 50; ++k)
+		port.push_back(instrument<>(5, pu0, pc0));
+
+	// price quotes
+	double dpv[5];
+	bucket_risk(port.size(), &port[0], fc, J, dpv, static_cast<const double*>(0), 3);
+	for (size_t k = 0; k < 5; ++k) {
+		double h = 1e-6, p[5] = {0, 0, 0, 0, 0};
+		yield_curve<> yp, ym;
+		std::vector<std::vector<double>> u_, c_;
+		p[k] = h;
+		build(yp, u_, c_, r, p);
+		p[k] = -h;
+		build(ym, u_, c_, r, p);
+		double d = (portfolio_value(port.size(), &port[0], yp.forward_curve())
+			- portfolio_value(port.size(), &port[0], ym.forward_curve()))/(2*h);
+		ensure (fabs(dpv[k] - d) < 1e-6*(1 + fabs(d)));
+	}
+
+	// rate quotes
+	double dq[5];
+	for (size_t k = 0; k < 5; ++k) {
+		dq[k] = 0;
+		for (size_t j = 1; j < u[k].size(); ++j)
+			dq[k] += (k < 2 ? u[k][j] : 1)*discount(u[k][j], fc);
+	}
+	bucket_risk(port.size(), &port[0], fc, J, dpv, dq, 1);
+	for (size_t k = 0; k < 5; ++k) {
+		double h = 1e-6, rp[5], rm[5];
+		std::copy(r, r + 5, rp);
+		std::copy(r, r + 5, rm);
+		rp[k] += h;
+		rm[k] -= h;
+		yield_curve<> yp, ym;
+		std::vector<std::vector<double>> u_, c_;
+		build(yp, u_, c_, rp);
+		build(ym, u_, c_, rm);
+		double d = (portfolio_value(port.size(), &port[0], yp.forward_curve())
+			- portfolio_value(port.size(), &port[0], ym.forward_curve()))/(2*h);
+		ensure (fabs(dpv[k] - d) < 1e-6*(1 + fabs(d)));
+	}
+}
+
+void
+test_convexity(void)
+{
+	double t[] = {0.5, 1, 2, 5};
+	double f[] = {0.01, 0.02, 0.025, 0.03};
+	double u[] = {0.25, 1, 1.5, 3, 6};
+	double c[] = {0.1, 0.2, 0.3, 0.4, 1.1};
+	instrument<> i(5, u, c);
+
+	for (double u0 = 0; u0 < 4; u0 += 0.75) {
+		double h = 1e-5;
+		double dp = duration(i, forward_curve<>(4, t, f, 0.035), u0);
+		// shift past u0 moves both f past u0 and _f
+		double fp[4], fm[4];
+		for (size_t k = 0; k < 4; ++k) {
+			fp[k] = f[k] + (t[k] > u0 ? h : 0);
+			fm[k] = f[k] - (t[k] > u0 ? h : 0);
+		}
+		// segments straddling u0 are shifted on part of the segment, use an extra knot
+		std::vector<double> tt(t, t + 4), fpp(fp, fp + 4), fmm(fm, fm + 4);
+		size_t k = std::upper_bound(t, t + 4, u0) - t;
+		if (u0 > 0 && k < 4 && t[k] != u0) {
+			tt.insert(tt.begin() + k, u0);
+			fpp.insert(fpp.begin() + k, f[k]);
+			fmm.insert(fmm.begin() + k, f[k]);
+		}
+		forward_curve<> cp(tt.size(), &tt[0], &fpp[0], 0.035 + h), cm(tt.size(), &tt[0], &fmm[0], 0.035 - h);
+		ensure (fabs((duration(i, cp, u0) - duration(i, cm, u0))/(2*h) - convexity(i, forward_curve<>(4, t, f, 0.035), u0)) < 1e-7);
+		ensure (fabs((present_value(i, cp) - present_value(i, cm))/(2*h) - dp) < 1e-8);
+	}
+}
+
+void
+test_knot_hessian(void)
+{
+	double t[] = {0.5, 1, 2, 5};
+	double f[] = {0.01, 0.02, 0.025, 0.03};
+	forward_curve<> fc(4, t, f, 0.035);
+	double u[] = {0.25, 1, 1.5, 3, 6};
+	double c[] = {0.1, 0.2, 0.3, 0.4, 1.1};
+
+	double H[16];
+	knot_gradient<> kg(fc);
+	kg.add(5, u, c).hessian(H);
+
+	for (size_t i = 0; i < 4; ++i) {
+		double h = 1e-5, gp[4], gm[4];
+		double fp[4], fm[4];
+		std::copy(f, f + 4, fp);
+		std::copy(f, f + 4, fm);
+		fp[i] += h;
+		fm[i] -= h;
+		knot_gradient<>(forward_curve<>(4, t, fp, 0.035)).add(5, u, c).gradient(gp);
+		knot_gradient<>(forward_curve<>(4, t, fm, 0.035)).add(5, u, c).gradient(gm);
+		for (size_t k = 0; k < 4; ++k) {
+			ensure (H[i*4 + k] == H[k*4 + i]);
+			ensure (fabs(H[i*4 + k] - (gp[k] - gm[k])/(2*h)) < 1e-8);
+		}
+	}
+}
+
+void
+test_bucket_gamma(void)
+{
+	double r[] = {0.01, 0.012, 0.015, 0.02, 0.025};
+	yield_curve<> yc;
+	std::vector<std::vector<double>> u, c;
+	build(yc, u, c, r);
+	auto fc = yc.forward_curve();
+
+	std::vector<instrument<>> ci;
+	for (size_t k = 0; k < 5; ++k)
+		ci.push_back(instrument<>(u[k].size(), &u[k][0], &c[k][0]));
+	bootstrap_jacobian<> J(5, &ci[0], fc);
+
+	double pu0[] = {0.25, 1.25, 2.25, 3.25, 4.25};
+	double pc0[] = {-1, 0.03, 0.03, 0.03, 1.03};
+	double pu1[] = {7};
+	double pc1[] = {100};
+	instrument<> port[] = {instrument<>(5, pu0, pc0), instrument<>(1, pu1, pc1)};
+
+	double dpv[5], gamma[25], d0[5];
+	bucket_gamma(2, port, fc, J, dpv, gamma, 2);
+	bucket_risk(2, port, fc, J, d0, static_cast<const double*>(0), 1);
+	for (size_t k = 0; k < 5; ++k)
+		ensure (fabs(dpv[k] - d0[k]) < 1e-12);
+
+	// bump price k and recompute delta
+	for (size_t k = 0; k < 5; ++k) {
+		double h = 1e-5, p[5] = {0, 0, 0, 0, 0};
+		double dp[5], dm[5];
+		std::vector<std::vector<double>> u_, c_;
+		yield_curve<> yp, ym;
+		p[k] = h;
+		build(yp, u_, c_, r, p);
+		p[k] = -h;
+		build(ym, u_, c_, r, p);
+		auto fp = yp.forward_curve(), fm = ym.forward_curve();
+		bucket_risk(2, port, fp, bootstrap_jacobian<>(5, &ci[0], fp), dp, static_cast<const double*>(0), 1);
+		bucket_risk(2, port, fm, bootstrap_jacobian<>(5, &ci[0], fm), dm, static_cast<const double*>(0), 1);
+		for (size_t j = 0; j < 5; ++j) {
+			ensure (fabs(gamma[j*5 + k] - gamma[k*5 + j]) < 1e-9*(1 + fabs(gamma[j*5 + k])));
+			ensure (fabs(gamma[j*5 + k] - (dp[j] - dm[j])/(2*h)) < 1e-5*(1 + fabs(gamma[j*5 + k])));
+		}
+	}
+}
+
+void
+test_sensitivities(void)
+{
+	double t[] = {0.5, 1, 2, 5};
+	double f[] = {0.01, 0.02, 0.025, 0.03};
+	double u[] = {0.25, 1, 1.5, 3, 6};
+	double c[] = {0.1, 0.2, 0.3, 0.4, 1.1};
+	instrument<> i(5, u, c);
+	forward_curve<> fc(4, t, f, 0.035);
+
+	for (double u0 = 0; u0 < 7; u0 += 0.5) {
+		sensitivity<> s = sensitivities(i, fc, u0);
+		ensure (fabs(s.pv - present_value(5, u, c, 4, t, f, 0.035)) < 1e-15);
+		ensure (fabs(s.dur - duration(5, u, c, 4, t, f, 0.035, u0)) < 1e-15);
+		ensure (s.cvx == convexity(i, fc, u0));
+		ensure (s.cvx >= 0);
+	}
+}
+
+void
+fms_test_risk(void)
+{
+	test_knot_gradient();
+	test_bucket_risk();
+	test_convexity();
+	test_knot_hessian();
+	test_bucket_gamma();
+	test_sensitivities();
+}
@@ -0,0 +1,87 @@
+// troll_down.cpp - test shifted curves and roll-down
+#include <cmath>
+#include <vector>
+#include "../ensure.h"
+#include "../roll_down.h"
+#include "../interest_rate_swap.h"
+
+using namespace fixed_income;
+using namespace pwflat;
+
+void
+test_shifted_curve(void)
+{
+	double t[] = {0.5, 1, 2, 5, 10};
+	double f[] = {0.01, 0.02, 0.025, 0.03, 0.035};
+	forward_curve<> fc(5, t, f, 0.04);
+
+	shifted_curve<> sc(fc, 1.5);
+	double t_[5], f_[5];
+	size_t n = shift(1.5, fc, t_, f_);
+	ensure (n == 3 && t_[0] == 0.5 && f_[0] == 0.025);
+	forward_curve<> fs(n, t_, f_, fc._f);
+
+	for (double u = 0; u < 12; u += 0.25) {
+		ensure (sc(u) == fc(1.5 + u));
+		ensure (fabs(sc.integral(u) - (fc.integral(1.5 + u) - fc.integral(1.5))) < 1e-15);
+		ensure (fabs(sc.integral(u) - fs.integral(u)) < 1e-14);
+	}
+	ensure (shift(20., fc, t_, f_) == 0);
+}
+
+void
+test_roll_down(void)
+{
+	double t[] = {0.5, 1, 2, 5, 10};
+	double f[] = {0.01, 0.02, 0.025, 0.03, 0.035};
+	forward_curve<> fc(5, t, f, 0.04);
+
+	date val(2012, 11, 11);
+	date eff(date(val).incr(2, datetime::UNIT_DAYS));
+	interest_rate_swap<> irs0(eff, 2, datetime::UNIT_YEARS, datetime::FREQ_QUARTERLY, datetime::DCB_ACTUAL_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+	interest_rate_swap<> irs1(eff, 5, datetime::UNIT_YEARS, datetime::FREQ_SEMIANNUALLY, datetime::DCB_30U_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+	irs0.fix(val, 0.02);
+	irs1.fix(val, 0.03);
+
+	std::vector<day_cash_flows<>> dcf;
+	dcf.push_back(day_cash_flows<>(irs0, val));
+	dcf.push_back(day_cash_flows<>(irs1, val));
+	std::vector<day_instrument<>> i(dcf.begin(), dcf.end());
+	int v = epoch_day(val);
+
+	// daily for a year
+	size_t nk = 366;
+	std::vector<int> k(nk);
+	for (size_t j = 0; j < nk; ++j)
+		k[j] = static_cast<int>(j);
+
+	std::vector<double> pv(nk*2), cash(nk*2);
+	double ts[5], fs[5];
+
+	roll_down(2, &i[0], v, nk, &k[0], fc, ROLL_DOWN_STATIC, &pv[0], &cash[0], 2);
+	for (size_t j = 0; j < nk; j += 17) {
+		for (size_t l = 0; l < 2; ++l) {
+			ensure (fabs(pv[j*2 + l] - present_value(i[l], v + k[j], fc)) < 1e-13);
+			double c = 0;
+			for (size_t m = 0; m < i[l].n; ++m)
+				if (i[l].d[m] >= v && i[l].d[m] < v + k[j])
+					c += i[l].c[m];
+			ensure (fabs(cash[j*2 + l] - c) < 1e-15);
+		}
+	}
+	ensure (cash[0] == 0 && cash[1] == 0);
+
+	roll_down(2, &i[0], v, nk, &k[0], fc, ROLL_DOWN_FORWARD, &pv[0], static_cast<double*>(0), 1);
+	for (size_t j = 0; j < nk; j += 17) {
+		forward_curve<> fk(shift(k[j]/365.25, fc, ts, fs), ts, fs, fc._f);
+		for (size_t l = 0; l < 2; ++l)
+			ensure (fabs(pv[j*2 + l] - present_value(i[l], v + k[j], fk)) < 1e-13);
+	}
+}
+
+void
+fms_test_roll_down(void)
+{
+	test_shifted_curve();
+	test_roll_down();
+}
@@ -0,0 +1,89 @@
+// tschedule_cache.cpp - test shared payment schedules
+#include <cmath>
+#include "../ensure.h"
+#include "../interest_rate_swap.h"
+#include "../forward_rate_agreement.h"
+#include "../cash_deposit.h"
+
+using namespace fixed_income;
+
+void
+test_schedule_cache(void)
+{
+	date val(2012, 11, 11);
+	date eff(date(val).incr(2, datetime::UNIT_DAYS));
+
+	schedules<double>().clear();
+
+	interest_rate_swap<> irs(eff, 5, datetime::UNIT_YEARS, datetime::FREQ_SEMIANNUALLY, datetime::DCB_30U_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+	irs.fix(val, 0.04);
+	ensure (schedules<double>().size() == 1);
+	ensure (irs.n == 11);
+
+	// compare with direct date arithmetic
+	date d0(eff);
+	ensure (irs.t[0] == eff.diffyears(val));
+	ensure (irs.c[0] == -1);
+	for (size_t i = 1; i < irs.n; ++i) {
+		date d1(eff);
+		d1.incr(6*static_cast<int>(i), datetime::UNIT_MONTHS).adjust(datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+		ensure (fabs(irs.t[i] - d1.diffyears(val)) < 1e-14);
+		ensure (fabs(irs.c[i] - (0.04*d1.diff_dcb(d0, datetime::DCB_30U_360) + (i + 1 == irs.n))) < 1e-14);
+		d0 = d1;
+	}
+
+	// same conventions share the schedule, refixing does not grow the flows
+	interest_rate_swap<> irs2(eff, 5, datetime::UNIT_YEARS, datetime::FREQ_SEMIANNUALLY, datetime::DCB_30U_360, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+	irs2.fix(date(val).incr(1, datetime::UNIT_DAYS), 0.03);
+	irs2.fix(val, 0.04);
+	ensure (schedules<double>().size() == 1);
+	ensure (irs2.n == irs.n);
+	for (size_t i = 0; i < irs.n; ++i) {
+		ensure (irs2.t[i] == irs.t[i]);
+		ensure (irs2.c[i] == irs.c[i]);
+	}
+
+	// times are measured from the valuation date
+	forward_rate_agreement<> fra(eff, 3, datetime::UNIT_MONTHS);
+	fra.fix(val, 0.03);
+	date d1(eff);
+	d1.incr(3, datetime::UNIT_MONTHS).adjust(datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+	ensure (fabs(fra.t[1] - d1.diffyears(val)) < 1e-14);
+	ensure (fabs(fra.c[1] - (1 + 0.03*d1.diff_dcb(eff, datetime::DCB_ACTUAL_360))) < 1e-14);
+	ensure (schedules<double>().size() == 2);
+
+	cash_deposit<> cd(2, 1, datetime::UNIT_MONTHS, datetime::DCB_ACTUAL_360);
+	cd.fix(val, 0.01);
+	ensure (cd.t[0] == eff.diffyears(val));
+	ensure (schedules<double>().size() == 3);
+
+	// new valuation dates evict the least recently used schedules
+	size_t capacity = schedules<double>().capacity();
+	schedules<double>().capacity(2);
+	ensure (schedules<double>().size() == 2);
+	auto s = schedules<double>().get(eff, 0, 5, datetime::UNIT_YEARS, datetime::FREQ_SEMIANNUALLY, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE, datetime::DCB_30U_360);
+	ensure (s->size() == irs.n);
+	for (int i = 1; i <= 10; ++i) {
+		cash_deposit<> cdi(2, 1, datetime::UNIT_MONTHS, datetime::DCB_ACTUAL_360);
+		cdi.fix(date(val).incr(i, datetime::UNIT_DAYS), 0.01);
+		ensure (schedules<double>().size() <= 2);
+	}
+	ensure (s->size() == irs.n); // still valid after eviction
+	schedules<double>().capacity(capacity);
+
+	// 18 months paid annually has a short last period ending at maturity
+	auto s18 = schedules<double>().get(eff, 0, 18, datetime::UNIT_MONTHS, datetime::FREQ_ANNUALLY, datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE, datetime::DCB_ACTUAL_360);
+	date mat(eff);
+	mat.incr(18, datetime::UNIT_MONTHS).adjust(datetime::ROLL_MODIFIED_FOLLOWING, datetime::CALENDAR_NONE);
+	ensure (s18->size() == 3);
+	ensure (s18->t[2] == static_cast<double>(mat.diffyears(eff)));
+	for (size_t i = 1; i < s18->size(); ++i)
+		ensure (s18->t[i] > s18->t[i-1] && s18->dcf[i] > 0);
+	ensure (s18->dcf[2] < s18->dcf[1]/2 + 0.01);
+}
+
+void
+fms_test_schedule_cache(void)
+{
+	test_schedule_cache();
+}
@@ -0,0 +1,115 @@
+// tsmooth_curve.cpp - test piecewise linear and monotone convex forward curves
+#include <cmath>
+#include <vector>
+#include "../ensure.h"
+#include "../pwlinear.h"
+#include "../monotone_convex.h"
+#include "../pwflat_yield_curve.h"
+
+using namespace fixed_income;
+
+// Simpson's rule
+template<class C>
+inline double simpson(const C& f, double a, double b, int n = 1000)
+{
+	double h = (b - a)/n, I = f(a) + f(b);
+
+	for (int i = 1; i < n; ++i)
+		I += (i%2 ? 4 : 2)*f(a + i*h);
+
+	return I*h/3;
+}
+
+void
+test_pwlinear(void)
+{
+	double t[] = {1, 2, 3, 5};
+	double f[] = {0.01, 0.02, 0.015, 0.03};
+	pwlinear::forward_curve<> fc(4, t, f);
+
+	ensure (fc.value(0.5) == 0.01);
+	ensure (fabs(fc.value(1.5) - 0.015) < 1e-15);
+	ensure (fc.value(6) == 0.03);
+	for (double u = 0; u < 6; u += 0.3)
+		ensure (fabs(fc.integral(u) - simpson(fc, 0, u)) < 1e-6);
+
+	// bootstrap a deposit and swaps reprices them
+	pwlinear::forward_curve<> yc;
+	double e = exp(0.04) - 1;
+	double u[] = {0, 1, 2, 3, 4};
+	double c[][5] = {
+		{-1, 1.04},
+		{-1, e, 1.05},
+		{-1, e, e, 1.06},
+		{-1, e, e, e, 1.055},
+	};
+	for (size_t k = 0; k < 4; ++k) {
+		yc.add(k + 2, u, c[k]);
+		double pv = 0;
+		for (size_t j = 0; j < k + 2; ++j)
+			pv += c[k][j]*yc.discount(u[j]);
+		ensure (fabs(pv) < 1e-14);
+	}
+	ensure (yc.size() == 4);
+	for (double u_ = 1; u_ <= 4; u_ += 1) // continuous at the knots
+		ensure (fabs(yc.value(u_ - 1e-9) - yc.value(u_ + 1e-9)) < 1e-7);
+
+	// common curve interface for pricing
+	const fixed_income::forward_curve<>& fi = yc;
+	for (size_t k = 0; k < 4; ++k) {
+		instrument<> ik(k + 2, u, c[k]);
+		ensure (fabs(present_value(ik, fi)) < 1e-14);
+		double h = 1e-6;
+		double pv_up = 0;
+		for (size_t j = 0; j < k + 2; ++j)
+			pv_up += c[k][j]*yc.discount(u[j])*exp(-h*u[j]);
+		ensure (fabs(duration(ik, fi) - pv_up/h) < 1e-5);
+	}
+}
+
+void
+test_monotone_convex(void)
+{
+	double t[] = {0.25, 0.5, 1, 2, 3, 5, 7, 10};
+	double fd[] = {0.02, 0.021, 0.025, 0.024, 0.03, 0.031, 0.029, 0.035};
+	size_t n = sizeof(t)/sizeof(*t);
+
+	pwflat::forward_curve<> pf(n, t, fd);
+	monotone_convex::forward_curve<> mc(pf);
+
+	ensure (mc.size() == n);
+	for (size_t i = 0; i < n; ++i) {
+		// same discount at knots
+		ensure (fabs(mc.integral(t[i]) - pf.integral(t[i])) < 1e-15);
+		// continuous up to the extrapolation
+		ensure (i + 1 == n || fabs(mc.value(t[i] - 1e-9) - mc.value(t[i] + 1e-9)) < 1e-7);
+		// analytic integral
+		double t0 = i ? t[i-1] : 0;
+		ensure (fabs(simpson(mc, t0, t[i]) - fd[i]*(t[i] - t0)) < 1e-10);
+		for (double u = t0; u < t[i]; u += (t[i] - t0)/7)
+			ensure (fabs(mc.integral(u) - mc.integral(t0) - simpson(mc, t0, u)) < 1e-10);
+	}
+	ensure (mc.value(11) == pf._f);
+
+	// monotone input gives monotone forwards
+	double fu[] = {0.01, 0.012, 0.02, 0.021, 0.03, 0.04, 0.041, 0.05};
+	monotone_convex::forward_curve<> mu(n, t, fu);
+	for (double u = 0.01; u < 9.99; u += 0.01)
+		ensure (mu.value(u) <= mu.value(u + 0.01) + 1e-15);
+
+	// built from a bootstrapped curve
+	pwflat::yield_curve<> yc;
+	yc.add(0.5, 1.01).add(1., 1.025).add(0., -1., 2., 1.06);
+	monotone_convex::forward_curve<> my(yc.forward_curve());
+	ensure (fabs(1.06*my.discount(2) - 1) < 1e-14);
+	ensure (fabs(1.01*my.discount(0.5) - 1) < 1e-14);
+	double u2[] = {0, 1, 2}, c2[] = {-1, 0, 1.06};
+	ensure (fabs(present_value(3, u2, c2, my) - (c2[0] + 1.06*my.discount(2))) < 1e-15);
+}
+
+void
+fms_test_smooth_curve(void)
+{
+	test_pwlinear();
+	test_monotone_convex();
+}
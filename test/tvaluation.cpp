@@ -20,7 +20,7 @@ fms_test_valuation(void)
 	double c[] = {-1, .1, .1, .1, 1.1};
 
 	double pc0(0), pv0(0), dur0(0);
-	for (int i = 0; i < dimof(u); ++i) {
+	for (size_t i = 0; i < dimof(u); ++i) {
 		if (i > 0)
 			pc0 += discount(u[i], F);
 		pv0 += c[i] * discount(u[i], F);
@@ -39,11 +39,34 @@ fms_test_valuation(void)
 
 	auto S = [](double t) { return exp(-0.01*t); };
 	double p = 0;
-	for (int i = 0; i < dimof(u); ++i)
+	for (size_t i = 0; i < dimof(u); ++i)
 		p += c[i] * discount(u[i], F)*0.5*(1 + S(u[i]));
 
 	pv = present_value<double>(instrument<>(5, u, c), F, 0.5, S);
 	ensure (fabs(p - pv) < eps);
+
+	// piecewise flat hazard rate
+	double th[] = {0.5, 2.5};
+	double h[] = {0.02, 0.03};
+	hazard_curve<> H(2, th, h, 0.04);
+	auto SH = [&H](double t) { return survival(t, H); };
+	p = present_value<double>(instrument<>(5, u, c), F, 0.4, SH);
+	pv = present_value(instrument<>(5, u, c), F, 0.4, H);
+	ensure (fabs(p - pv) < 2*eps);
+
+	p = present_value<double>(fixed_leg<>(5, u, c_), F, 0.4, SH);
+	pv = present_value(fixed_leg<>(5, u, c_), F, 0.4, H);
+	ensure (fabs(p - pv) < 2*eps);
+
+	p = present_value<double>(float_leg<>(5, u), F, 0.4, SH);
+	pv = present_value(float_leg<>(5, u), F, 0.4, H);
+	ensure (fabs(p - pv) < 2*eps);
+
+	// cursor agrees with integral for increasing and decreasing times
+	integral_cursor<double> I(F);
+	for (double s = -1; s < 5; s += 0.25)
+		ensure (I(s) == integral(s, F));
+	ensure (I(1.5) == integral(1.5, F));
 /*
 	c_[0] = c[1];
 	double pvi = present_value<double>(fixed_leg<>(5, u, c_), F, 0.5, S);
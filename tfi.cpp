@@ -1,4 +1,5 @@
 // tfi.cpp - test fi.h 
+#include <cmath>
 #include "ensure.h"
 #include "fi.h"
 
@@ -55,14 +56,14 @@ test_piecewise_constant(void)
 	ensure (F(t[0]) == f[0]);
 	ensure (F(t[1]) == f[1]);
 	ensure (F(t[2]) == f[2]);
-	ensure (_isnan(F(4)));
+	ensure (std::isnan(F(4)));
 	ensure (F(-1) == f[0]);
 
 	piecewise_constant<T> F1(F);
 	ensure (F1(t[0]) == f[0]);
 	ensure (F1(t[1]) == f[1]);
 	ensure (F1(t[2]) == f[2]);
-	ensure (_isnan(F1(4)));
+	ensure (std::isnan(F1(4)));
 	ensure (F1(-1) == f[0]);
 
 	piecewise_constant<T> F2;
@@ -70,14 +71,14 @@ test_piecewise_constant(void)
 	ensure (F2(t[0]) == f[0]);
 	ensure (F2(t[1]) == f[1]);
 	ensure (F2(t[2]) == f[2]);
-	ensure (_isnan(F2(4)));
+	ensure (std::isnan(F2(4)));
 	ensure (F2(-1) == f[0]);
 
 	F = F2;
 	ensure (F(t[0]) == f[0]);
 	ensure (F(t[1]) == f[1]);
 	ensure (F(t[2]) == f[2]);
-	ensure (_isnan(F(4)));
+	ensure (std::isnan(F(4)));
 	ensure (F(-1) == f[0]);
 
 	ensure (extrapolate(F, constant<T>(5.))(4) == 5);